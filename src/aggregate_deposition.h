@@ -42,15 +42,25 @@
 #include <break_neck.h>
 
 #include "simulation.h"
+#include "dump_diagnostics.h"
+#include "checkpoint.h"
+#include "aggregate_loader.h"
+#include "neck_information.h"
+#include "spatial_ordering.h"
+#include "substrate_cutoff.h"
+#include "sleeping_step_handler.h"
 
 class AggregateDepositionSimulation : public Simulation {
 public:
     using aggregate_model_t = aggregate<Eigen::Vector3d, double>;
     using rect_substrate_model_t = rect_substrate<Eigen::Vector3d, double>;
-    using binary_force_container_t = binary_force_functor_container<Eigen::Vector3d, double, aggregate_model_t>;
-    using unary_force_container_t = unary_force_functor_container<Eigen::Vector3d, double, rect_substrate_model_t>;
+    using substrate_cutoff_model_t = substrate_cutoff_functor<Eigen::Vector3d, double, rect_substrate_model_t>;
+    using aggregate_filter_model_t = sleeping_force_filter<Eigen::Vector3d, double, aggregate_model_t>;
+    using substrate_filter_model_t = sleeping_force_filter<Eigen::Vector3d, double, substrate_cutoff_model_t>;
+    using binary_force_container_t = binary_force_functor_container<Eigen::Vector3d, double, aggregate_filter_model_t>;
+    using unary_force_container_t = unary_force_functor_container<Eigen::Vector3d, double, substrate_filter_model_t>;
     using granular_system_t = granular_system_neighbor_list<Eigen::Vector3d, double, rotational_velocity_verlet_half,
-            rotational_step_handler, binary_force_container_t, unary_force_container_t>;
+            sleeping_step_handler, binary_force_container_t, unary_force_container_t>;
 
     explicit AggregateDepositionSimulation(
             parameter_heap_t const & parameter_heap,
@@ -146,8 +156,11 @@ public:
     static constexpr std::tuple<const char *, ParameterType, const char *> PARAMETERS[] {
             {"A", REAL, "Hamaker constant"},
             {"A_substrate", REAL, "Substrate Hamaker constant"},
+            {"aggregate_df", REAL, "Fractal dimension of a generated aggregate"},
+            {"aggregate_kf", REAL, "Fractal prefactor of a generated aggregate"},
             {"d_crit", REAL, "Critical separation for a contact"},
             {"dt", REAL, "Integration time step"},
+            {"dt_safety_factor", REAL, "Upper bound for dt as a fraction of the critical time step (0 to disable)"},
             {"gamma_n", REAL, "Normal damping coefficient"},
             {"gamma_n_bond", REAL, "Normal bond damping coefficient"},
             {"gamma_n_substrate", REAL, "Normal substrate damping coefficient"},
@@ -192,11 +205,18 @@ public:
             {"rot_x", REAL, "Rotate aggregate about x-axis"},
             {"rot_y", REAL, "Rotate aggregate about y-axis"},
             {"rot_z", REAL, "Rotate aggregate about z-axis"},
+            {"sleep_ke", REAL, "Kinetic energy below which a particle with slow bonded neighbors stops being integrated (0 to disable)"},
             {"vz0", REAL, "Initial downward velocity of the aggregate"},
+            {"substrate_cutoff", REAL, "Height above the substrate beyond which substrate forces are neglected, the force is shifted to vanish there (0 to disable)"},
             {"substrate_size", REAL, "Size of the substrate"},
+            {"aggregate_n_part", INTEGER, "Number of primaries in a generated aggregate"},
+            {"aggregate_seed", INTEGER, "Random number generator seed for a generated aggregate"},
+            {"checkpoint_period", INTEGER, "Checkpoint period in dumps (0 to disable)"},
             {"dump_period", INTEGER, "Dump period"},
             {"neighbor_update_period", INTEGER, "Neighbor list update period"},
-            {"aggregate_type", STRING, "vtk / flage / mackowski"},
+            {"reorder_particles", INTEGER, "Reorder particles along a Morton curve (0 / 1)"},
+            {"resume_checkpoint", INTEGER, "Resume from the last checkpoint on initialization (0 / 1)"},
+            {"aggregate_type", STRING, "vtk / flage / mackowski / generated"},
             {"aggregate_path", PATH, "Path to the aggregate file"},
     };
     static constexpr size_t N_PARAMETERS = sizeof(PARAMETERS) / sizeof(PARAMETERS[0]);
@@ -206,15 +226,25 @@ public:
 
 
 private:
+    void write_checkpoint() const;
+    bool restore_checkpoint(std::ostream & output_stream, double r_verlet);
+    void write_dump() const;
+
     double mass, inertia, r_part, dt;
-    long dump_period, neighbor_update_period;
+    long dump_period, neighbor_update_period, checkpoint_period;
+    bool resume_checkpoint;
     size_t current_step = 0;
+    std::vector<Eigen::Vector3d> x_prev; // Particle positions at the previous dump
+    std::vector<size_t> particle_order; // Original index of each particle, empty if the particles were not reordered
     std::unique_ptr<rect_substrate_model_t> substrate_model;
+    std::unique_ptr<substrate_cutoff_model_t> substrate_cutoff_model;
     std::unique_ptr<aggregate_model_t> aggregate_model;
+    std::unique_ptr<aggregate_filter_model_t> aggregate_filter_model;
+    std::unique_ptr<substrate_filter_model_t> substrate_filter_model;
     std::unique_ptr<unary_force_container_t> unary_force_container;
     std::unique_ptr<binary_force_container_t> binary_force_container;
     std::unique_ptr<granular_system_t> granular_system;
-    rotational_step_handler<std::vector<Eigen::Vector3d>, Eigen::Vector3d> step_handler_instance;
+    sleeping_step_handler<std::vector<Eigen::Vector3d>, Eigen::Vector3d> step_handler_instance;
 };
 
 #endif //GUI_DESIGN_SOOT_DEM_AGGREGATE_DEPOSITION_H
@@ -0,0 +1,203 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+#include "exceptions.h"
+#include "aggregate_generator.h"
+
+// Number of points tried on the contact circle of one primary before another primary is tried
+static constexpr long CIRCLE_ATTEMPTS = 32;
+
+// Number of times the whole aggregate is restarted when a primary cannot be attached
+static constexpr long RESTART_ATTEMPTS = 100;
+
+// Hash of cubic cells one diameter wide, in units of the primary radius
+class AggregateSpatialHash {
+public:
+    bool overlaps(Eigen::Vector3d const & particle, std::vector<Eigen::Vector3d> const & xs) const {
+        auto [cx, cy, cz] = get_cell(particle);
+        for (long ix = cx - 1; ix <= cx + 1; ix ++) {
+            for (long iy = cy - 1; iy <= cy + 1; iy ++) {
+                for (long iz = cz - 1; iz <= cz + 1; iz ++) {
+                    auto cell = cells.find(get_key(ix, iy, iz));
+                    if (cell == cells.end())
+                        continue;
+                    for (size_t j : cell->second) {
+                        // The attachment point is exactly one diameter away from its partner
+                        if ((xs[j] - particle).norm() < 2.0 - 1e-9)
+                            return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void insert(size_t index, Eigen::Vector3d const & particle) {
+        auto [cx, cy, cz] = get_cell(particle);
+        cells[get_key(cx, cy, cz)].emplace_back(index);
+    }
+
+private:
+    static std::array<long, 3> get_cell(Eigen::Vector3d const & particle) {
+        return {long(std::floor(particle[0] / 2.0)), long(std::floor(particle[1] / 2.0)), long(std::floor(particle[2] / 2.0))};
+    }
+
+    static uint64_t get_key(long ix, long iy, long iz) {
+        constexpr long offset = 1l << 20;
+        return uint64_t(ix + offset) << 42 | uint64_t(iy + offset) << 21 | uint64_t(iz + offset);
+    }
+
+    std::unordered_map<uint64_t, std::vector<size_t>> cells;
+};
+
+static Eigen::Vector3d get_random_unit_vector(std::mt19937_64 & engine) {
+    std::normal_distribution<double> dist(0.0, 1.0);
+    Eigen::Vector3d vec;
+    do {
+        vec = {dist(engine), dist(engine), dist(engine)};
+    } while (vec.norm() == 0);
+    return vec.normalized();
+}
+
+// Squared radius of gyration of an aggregate of n primaries of unit radius that follows the fractal law
+static double get_target_rg_squared(long n, double fractal_dimension, double fractal_prefactor) {
+    return std::pow(double(n) / fractal_prefactor, 2.0 / fractal_dimension);
+}
+
+// Attempts to build the aggregate once. Returns an empty vector if a primary could not be attached
+static std::vector<Eigen::Vector3d> try_generate_aggregate(AggregateGeneratorParameters const & parameters,
+                                                           std::mt19937_64 & engine) {
+    std::vector<Eigen::Vector3d> x;
+    x.reserve(parameters.n_part);
+    AggregateSpatialHash spatial_hash;
+
+    // Start from a dimer
+    x.emplace_back(Eigen::Vector3d::Zero());
+    spatial_hash.insert(0, x.back());
+    if (parameters.n_part > 1) {
+        x.emplace_back(2.0 * get_random_unit_vector(engine));
+        spatial_hash.insert(1, x.back());
+    }
+
+    Eigen::Vector3d center_of_mass = std::accumulate(x.begin(), x.end(), Eigen::Vector3d::Zero().eval()) / double(x.size());
+    std::uniform_real_distribution<double> angle_dist(0.0, 2.0 * M_PI);
+
+    // n * Rg^2 of the current aggregate. The dimer does not follow the fractal law, and the primaries added to it
+    // correct the offset as far as they can reach, so that the law holds exactly once the offset is absorbed
+    double sum_rg_squared = 0.0;
+    for (auto const & particle : x) {
+        sum_rg_squared += (particle - center_of_mass).squaredNorm();
+    }
+
+    for (long n = long(x.size()); n < parameters.n_part; n ++) {
+        // Distance from the current center of mass at which the new primary brings n * Rg^2 to the target of n + 1 primaries
+        double gamma_squared = double(n + 1) / double(n) * (
+                double(n + 1) * get_target_rg_squared(n + 1, parameters.fractal_dimension, parameters.fractal_prefactor)
+                - sum_rg_squared);
+        if (gamma_squared <= 0.0)
+            return {};
+
+        // No primary can be placed farther than one diameter beyond the outermost one, the rest is left to the next primaries
+        double max_distance = 0.0;
+        for (auto const & particle : x) {
+            max_distance = std::max(max_distance, (particle - center_of_mass).norm());
+        }
+        double gamma = std::min(std::sqrt(gamma_squared), max_distance + 2.0);
+        gamma_squared = gamma * gamma;
+
+        // The sphere of that radius intersects the contact sphere of the primaries within one diameter of its surface
+        std::vector<size_t> candidates;
+        for (size_t j = 0; j < x.size(); j ++) {
+            if (std::abs((x[j] - center_of_mass).norm() - gamma) <= 2.0)
+                candidates.emplace_back(j);
+        }
+        std::shuffle(candidates.begin(), candidates.end(), engine);
+
+        bool attached = false;
+        for (size_t j : candidates) {
+            // Circle on which the sphere about the center of mass meets the contact sphere of primary j
+            Eigen::Vector3d axis = x[j] - center_of_mass;
+            double d = axis.norm();
+            if (d == 0.0)
+                continue;
+            axis /= d;
+            double s = (gamma_squared - 4.0 + d * d) / (2.0 * d);
+            double circle_radius = std::sqrt(std::max(gamma_squared - s * s, 0.0));
+
+            Eigen::Vector3d e1 = axis.unitOrthogonal();
+            Eigen::Vector3d e2 = axis.cross(e1);
+
+            for (long attempt = 0; attempt < CIRCLE_ATTEMPTS && !attached; attempt ++) {
+                double phi = angle_dist(engine);
+                Eigen::Vector3d particle = center_of_mass + s * axis + circle_radius * (std::cos(phi) * e1 + std::sin(phi) * e2);
+                if (spatial_hash.overlaps(particle, x))
+                    continue;
+
+                spatial_hash.insert(x.size(), particle);
+                x.emplace_back(particle);
+                attached = true;
+            }
+
+            if (attached)
+                break;
+        }
+
+        if (!attached)
+            return {};
+
+        sum_rg_squared += double(n) / double(n + 1) * (x.back() - center_of_mass).squaredNorm();
+        center_of_mass = (double(n) * center_of_mass + x.back()) / double(n + 1);
+    }
+
+    for (auto & particle : x) {
+        particle -= center_of_mass;
+    }
+
+    return x;
+}
+
+std::vector<Eigen::Vector3d> generate_aggregate(AggregateGeneratorParameters const & parameters, double r_part) {
+    if (parameters.n_part < 1)
+        throw UiException("A generated aggregate must contain at least one primary");
+    if (parameters.fractal_dimension <= 1.0 || parameters.fractal_dimension > 3.0)
+        throw UiException("The fractal dimension of a generated aggregate must be in (1, 3]");
+    if (parameters.fractal_prefactor <= 0.0)
+        throw UiException("The fractal prefactor of a generated aggregate must be positive");
+
+    std::mt19937_64 engine(parameters.seed);
+
+    for (long restart = 0; restart < RESTART_ATTEMPTS; restart ++) {
+        auto x = try_generate_aggregate(parameters, engine);
+        if (x.empty())
+            continue;
+
+        for (auto & particle : x) {
+            particle *= r_part;
+        }
+        return x;
+    }
+
+    throw UiException("Unable to generate an aggregate with the requested fractal dimension and prefactor");
+}
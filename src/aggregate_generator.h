@@ -0,0 +1,43 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SOOT_DEM_GUI_AGGREGATE_GENERATOR_H
+#define SOOT_DEM_GUI_AGGREGATE_GENERATOR_H
+
+#include <vector>
+
+#include <Eigen/Eigen>
+
+// Target morphology of an aggregate produced in-process for aggregate_type "generated".
+// The radius of gyration Rg of the aggregate follows n_part = fractal_prefactor * (Rg / r_part)^fractal_dimension
+struct AggregateGeneratorParameters {
+    long n_part;
+    double fractal_dimension;
+    double fractal_prefactor;
+    long seed;
+};
+
+// Tunable particle-cluster aggregation (Filippov et al., 2000): primaries are added one at a time to a dimer,
+// each touching the aggregate at the distance from its center of mass that makes the aggregate follow the fractal law.
+// The initial dimer is more compact than the law requires for small fractal prefactors; the first primaries then
+// attach as far out as they can, and the law holds exactly from the primary at which this offset is absorbed on.
+// Overlaps are checked against a spatial hash, so the cost per primary does not depend on the aggregate size
+// apart from choosing the primary to attach to. The aggregate is centered at the origin.
+// Throws UiException if the parameters are invalid or no aggregate satisfying them could be built
+std::vector<Eigen::Vector3d> generate_aggregate(AggregateGeneratorParameters const & parameters, double r_part);
+
+#endif //SOOT_DEM_GUI_AGGREGATE_GENERATOR_H
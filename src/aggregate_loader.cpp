@@ -0,0 +1,151 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#include <reader.h>
+
+#include "checkpoint.h"
+#include "aggregate_loader.h"
+
+static constexpr const char * AGGREGATE_CACHE_SIGNATURE = "aggregate_cache";
+
+// Number of distinct aggregates kept in memory by the process-wide cache
+static constexpr size_t MEMORY_CACHE_CAPACITY = 16;
+
+static std::mutex memory_cache_mutex;
+static std::map<std::string, std::vector<Eigen::Vector3d>> memory_cache; // Keyed by the path and the source fingerprint
+
+static std::vector<Eigen::Vector3d> parse_aggregate(std::string const & aggregate_type,
+                                                    std::filesystem::path const & aggregate_path,
+                                                    double r_part) {
+    if (aggregate_type == "vtk")
+        return load_vtk_aggregate(aggregate_path, r_part);
+    if (aggregate_type == "mackowski")
+        return load_mackowski_aggregate(aggregate_path, r_part);
+    if (aggregate_type == "flage")
+        return load_flage_aggregate(aggregate_path, r_part);
+    throw UiException("Unrecognized aggregate type: " + aggregate_type);
+}
+
+// Identifies the parsed contents: the cache is invalidated when the source file or the loading parameters change
+static std::string get_source_fingerprint(std::string const & aggregate_type,
+                                          std::filesystem::path const & aggregate_path,
+                                          double r_part) {
+    std::stringstream ss;
+    ss << aggregate_type << ';' << std::hexfloat << r_part << ';'
+       << std::filesystem::file_size(aggregate_path) << ';'
+       << std::filesystem::last_write_time(aggregate_path).time_since_epoch().count();
+    return ss.str();
+}
+
+static std::vector<Eigen::Vector3d> load_aggregate_from_file(std::string const & aggregate_type,
+                                                             std::filesystem::path const & aggregate_path,
+                                                             double r_part) {
+    auto cache_path = std::filesystem::path(aggregate_path).concat(".agg.bin");
+    auto fingerprint = get_source_fingerprint(aggregate_type, aggregate_path, r_part);
+
+    if (std::filesystem::exists(cache_path)) {
+        try {
+            CheckpointReader reader(cache_path, AGGREGATE_CACHE_SIGNATURE);
+            if (reader.get_parameter_fingerprint() == fingerprint) {
+                std::vector<Eigen::Vector3d> x;
+                reader.read(x);
+                return x;
+            }
+        } catch (UiException const &) {
+            // A corrupt cache is regenerated below
+        }
+    }
+
+    auto x = parse_aggregate(aggregate_type, aggregate_path, r_part);
+
+    if (!x.empty()) {
+        try {
+            CheckpointWriter writer(cache_path, AGGREGATE_CACHE_SIGNATURE, fingerprint);
+            writer.write(x);
+            writer.commit();
+        } catch (UiException const &) {
+            // The aggregate may be in a read-only location, the cache is only an optimization
+        }
+    }
+
+    return x;
+}
+
+// Generated aggregates are deterministic in their parameters, so they share the memory cache with the files
+static std::vector<Eigen::Vector3d> load_generated_aggregate(AggregateGeneratorParameters const & generator_parameters,
+                                                             double r_part) {
+    std::stringstream ss;
+    ss << "generated;" << std::hexfloat << r_part << ';' << generator_parameters.fractal_dimension << ';'
+       << generator_parameters.fractal_prefactor << ';' << std::dec << generator_parameters.n_part << ';'
+       << generator_parameters.seed;
+    auto fingerprint = ss.str();
+
+    {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        auto cached = memory_cache.find(fingerprint);
+        if (cached != memory_cache.end())
+            return cached->second;
+    }
+
+    auto x = generate_aggregate(generator_parameters, r_part);
+
+    {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        if (memory_cache.size() >= MEMORY_CACHE_CAPACITY)
+            memory_cache.clear();
+        memory_cache.emplace(fingerprint, x);
+    }
+
+    return x;
+}
+
+std::vector<Eigen::Vector3d> load_aggregate(std::string const & aggregate_type,
+                                            std::filesystem::path const & aggregate_path,
+                                            double r_part,
+                                            AggregateGeneratorParameters const & generator_parameters) {
+    if (aggregate_type == "generated")
+        return load_generated_aggregate(generator_parameters, r_part);
+
+    if (!std::filesystem::is_regular_file(aggregate_path))
+        return parse_aggregate(aggregate_type, aggregate_path, r_part);
+
+    // Only metadata is consulted here, so a cache hit never reads the aggregate file
+    auto memory_key = std::filesystem::absolute(aggregate_path).lexically_normal().string() + ';'
+            + get_source_fingerprint(aggregate_type, aggregate_path, r_part);
+
+    {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        auto cached = memory_cache.find(memory_key);
+        if (cached != memory_cache.end())
+            return cached->second;
+    }
+
+    auto x = load_aggregate_from_file(aggregate_type, aggregate_path, r_part);
+
+    if (!x.empty()) {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        if (memory_cache.size() >= MEMORY_CACHE_CAPACITY)
+            memory_cache.clear();
+        memory_cache.emplace(memory_key, x);
+    }
+
+    return x;
+}
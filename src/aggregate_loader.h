@@ -0,0 +1,40 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_AGGREGATE_LOADER_H
+#define SOOT_DEM_GUI_AGGREGATE_LOADER_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include "aggregate_generator.h"
+
+// Load an aggregate of the given type (vtk / flage / mackowski / generated).
+// Generated aggregates are built in-process from the generator parameters and the path is ignored; the other
+// types are read from the file and ignore the generator parameters.
+// Aggregates loaded earlier in the same process are looked up by path, size and modification time.
+// Otherwise, the parsed positions are stored in a binary sidecar file (<aggregate file>.agg.bin) and reused
+// on subsequent loads as long as the size and modification time of the aggregate file are unchanged.
+// Throws UiException if the aggregate type is not recognized or the aggregate cannot be generated
+std::vector<Eigen::Vector3d> load_aggregate(std::string const & aggregate_type,
+                                            std::filesystem::path const & aggregate_path,
+                                            double r_part,
+                                            AggregateGeneratorParameters const & generator_parameters);
+
+#endif //SOOT_DEM_GUI_AGGREGATE_LOADER_H
@@ -17,15 +17,55 @@
 #include <iomanip>
 #include "format_wrapper.h"
 
+#include "trace.h"
 #include "aggregation.h"
 
-bool particle_overlaps(Eigen::Vector3d const & particle,
-                       std::vector<Eigen::Vector3d> const & xs,
-                       double r_part) {
-    return std::any_of(xs.begin(), xs.end(), [&particle, r_part] (Eigen::Vector3d const & x) {
-        return (x - particle).norm() < 2.0 * r_part;
-    });
-}
+// Uniform grid over the box used during random placement, so that a candidate particle
+// is only compared against the particles already placed in the neighboring cells
+class PlacementGrid {
+public:
+    PlacementGrid(double box_size, double r_part, size_t n_part)
+        : box_size{box_size} {
+        // Cells must be at least one diameter wide; their number is capped to keep sparse boxes cheap
+        auto max_cells = std::max(long(std::ceil(2.0 * std::cbrt(double(n_part)))), 1l);
+        n_cells = std::clamp(long(box_size / (2.0 * r_part)), 1l, max_cells);
+        cell_size = box_size / double(n_cells);
+        cells.resize(n_cells * n_cells * n_cells);
+    }
+
+    bool overlaps(Eigen::Vector3d const & particle, std::vector<Eigen::Vector3d> const & xs, double r_part) const {
+        auto [cx, cy, cz] = get_cell(particle);
+        for (long ix = std::max(cx - 1, 0l); ix <= std::min(cx + 1, n_cells - 1); ix ++) {
+            for (long iy = std::max(cy - 1, 0l); iy <= std::min(cy + 1, n_cells - 1); iy ++) {
+                for (long iz = std::max(cz - 1, 0l); iz <= std::min(cz + 1, n_cells - 1); iz ++) {
+                    for (size_t j : cells[(ix * n_cells + iy) * n_cells + iz]) {
+                        if ((xs[j] - particle).norm() < 2.0 * r_part)
+                            return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void insert(size_t index, Eigen::Vector3d const & particle) {
+        auto [cx, cy, cz] = get_cell(particle);
+        cells[(cx * n_cells + cy) * n_cells + cz].emplace_back(index);
+    }
+
+private:
+    std::array<long, 3> get_cell(Eigen::Vector3d const & particle) const {
+        std::array<long, 3> cell;
+        for (long dim = 0; dim < 3; dim ++) {
+            cell[dim] = std::clamp(long((particle[dim] + box_size / 2.0) / cell_size), 0l, n_cells - 1);
+        }
+        return cell;
+    }
+
+    double box_size, cell_size;
+    long n_cells;
+    std::vector<std::vector<size_t>> cells;
+};
 
 Eigen::Vector3d get_random_unit_vector() {
     Eigen::Vector3d vec;
@@ -49,19 +89,71 @@ const std::array<Eigen::Vector3d, 6> box_faces {
         Eigen::Vector3d::UnitZ(),
 };
 
-void bounce_off_walls(std::vector<Eigen::Vector3d> const & particles,
-                      std::vector<Eigen::Vector3d> & velocities,
+template<typename field_type>
+void bounce_off_walls(std::vector<field_type> const & particles,
+                      std::vector<field_type> & velocities,
                       double r_part, double box_size) {
-    for (size_t n = 0; n < box_faces.size(); n ++) {
-        for (size_t i = 0; i < particles.size(); i ++) {
-            if (velocities[i].dot(box_faces[n]) > 0.0 && box_size / 2.0 - particles[i].dot(box_faces[n]) < r_part) {
-                velocities[i] -= 2.0 * velocities[i].dot(box_faces[n]) * box_faces[n];
-//                std::cout << "Condition met\n";
+    const long n_part = long(particles.size());
+    #pragma omp parallel for default(none) shared(particles, velocities, r_part, box_size, n_part, box_faces)
+    for (long i = 0; i < n_part; i ++) {
+        for (size_t n = 0; n < box_faces.size(); n ++) {
+            const field_type face = box_faces[n].template cast<typename field_type::Scalar>();
+            if (velocities[i].dot(face) > 0.0 && box_size / 2.0 - particles[i].dot(face) < r_part) {
+                velocities[i] -= 2.0 * velocities[i].dot(face) * face;
             }
         }
     }
 }
 
+template<typename force_real_t>
+AggregationSimulation::force_models<force_real_t>::force_models(AggregationSimulation const & simulation, size_t n_part, double r_verlet)
+    : contact_model{n_part,
+                    force_real_t(simulation.get_real_parameter("k_n")), force_real_t(simulation.get_real_parameter("gamma_n")),
+                    force_real_t(simulation.get_real_parameter("k_t")), force_real_t(simulation.get_real_parameter("gamma_t")),
+                    force_real_t(simulation.get_real_parameter("mu_t")), force_real_t(simulation.get_real_parameter("phi_t")),
+                    force_real_t(simulation.get_real_parameter("k_r")), force_real_t(simulation.get_real_parameter("gamma_r")),
+                    force_real_t(simulation.get_real_parameter("mu_r")), force_real_t(simulation.get_real_parameter("phi_r")),
+                    force_real_t(simulation.get_real_parameter("k_o")), force_real_t(simulation.get_real_parameter("gamma_o")),
+                    force_real_t(simulation.get_real_parameter("mu_o")), force_real_t(simulation.get_real_parameter("phi_o")),
+                    force_real_t(simulation.r_part), force_real_t(simulation.mass), force_real_t(simulation.inertia), force_real_t(simulation.dt),
+                    force_field_t::Zero(), 0.0}
+    , hamaker_model{force_real_t(simulation.get_real_parameter("A")), force_real_t(simulation.get_real_parameter("h0")),
+                    force_real_t(simulation.r_part), force_real_t(simulation.mass), force_field_t::Zero(), 0.0}
+    // The Hamaker force is held constant for gaps below h0, the kink at 2 r_part + h0 becomes a knot of the table
+    , hamaker_table_model{hamaker_model, force_real_t(simulation.r_part), force_real_t(r_verlet),
+                          size_t(std::max(simulation.get_integer_parameter("force_table_size"), 0l)),
+                          force_real_t(2.0 * simulation.r_part + simulation.get_real_parameter("h0"))}
+    , hamaker_cutoff_model{hamaker_table_model, force_real_t(simulation.get_real_parameter("hamaker_cutoff"))}
+    , contact_precision_model{contact_model}
+    , hamaker_precision_model{hamaker_cutoff_model}
+    , binary_force_container{contact_precision_model, hamaker_precision_model} {}
+
+// Integrates a separate copy of the initial state for n_steps with the pair forces evaluated in force_real_t precision
+template<typename force_real_t>
+std::vector<Eigen::Vector3d> AggregationSimulation::integrate_initial_state(std::vector<Eigen::Vector3d> const & x0,
+                                                                            std::vector<Eigen::Vector3d> const & v0,
+                                                                            std::vector<Eigen::Vector3d> const & theta0,
+                                                                            std::vector<Eigen::Vector3d> const & omega0,
+                                                                            double r_verlet, long n_steps) const {
+    TRACE_SCOPE("integrate_initial_state");
+
+    force_models<force_real_t> models(*this, x0.size(), r_verlet);
+    unary_force_container_t unary_forces;
+    rotational_step_handler<std::vector<field_type>, field_type> step_handler;
+    granular_system_neighbor_list_mutable_velocity<force_real_t> system(x0.size(), r_verlet, x0, v0, theta0, omega0,
+                                                                        0.0, field_type::Zero(), 0.0,
+                                                                        step_handler, models.binary_force_container, unary_forces);
+
+    for (long n = 0; n < n_steps; n ++) {
+        if (n % neighbor_update_period == 0)
+            system.update_neighbor_list();
+        system.do_step(dt);
+        bounce_off_walls(system.get_x(), system.get_v(), r_part, box_size);
+    }
+
+    return system.get_x();
+}
+
 AggregationSimulation::AggregationSimulation(
             parameter_heap_t const & parameter_heap,
             std::filesystem::path const & working_directory
@@ -71,31 +163,20 @@ bool AggregationSimulation::initialize(std::ostream &output_stream, std::vector<
                                        std::vector<Eigen::Vector3d> &neck_positions_buffer,
                                        std::vector<Eigen::Vector3d> &neck_orientations_buffer,
                                        std::vector<std::vector<Eigen::Vector3d>> & polygons) {
+    TRACE_SCOPE("Simulation::initialize");
     auto rng_seed = get_integer_parameter("rng_seed");
 
     // General parameters
     auto rho = get_real_parameter("rho");
     auto r_verlet = get_real_parameter("r_verlet");
 
-    // Parameters for the contact model
+    // Stiffnesses of the contact model, the force models read the remaining contact and Van der Waals parameters themselves
     auto k_n = get_real_parameter("k_n");
-    auto gamma_n = get_real_parameter("gamma_n");
     auto k_t = get_real_parameter("k_t");
-    auto gamma_t = get_real_parameter("gamma_t");
-    auto mu_t = get_real_parameter("mu_t");
-    auto phi_t = get_real_parameter("phi_t");
     auto k_r = get_real_parameter("k_r");
-    auto gamma_r = get_real_parameter("gamma_r");
-    auto mu_r = get_real_parameter("mu_r");
-    auto phi_r = get_real_parameter("phi_r");
     auto k_o = get_real_parameter("k_o");
-    auto gamma_o = get_real_parameter("gamma_o");
-    auto mu_o = get_real_parameter("mu_o");
-    auto phi_o = get_real_parameter("phi_o");
 
-    // Parameters for the Van der Waals model
-    auto A = get_real_parameter("A");
-    auto h0 = get_real_parameter("h0");
+    auto force_table_tolerance = get_real_parameter("force_table_tolerance");
 
     // Aggregation set up parameters
     const long n_part = get_integer_parameter("n_part");
@@ -106,28 +187,58 @@ bool AggregationSimulation::initialize(std::ostream &output_stream, std::vector<
     dt = get_real_parameter("dt");
     dump_period = get_integer_parameter("dump_period");
     neighbor_update_period = get_integer_parameter("neighbor_update_period");
+    checkpoint_period = get_integer_parameter("checkpoint_period");
+    resume_checkpoint = get_integer_parameter("resume_checkpoint") != 0;
     r_part = get_real_parameter("r_part");
     mass = 4.0 / 3.0 * M_PI * pow(r_part, 3.0) * rho;
     inertia = 2.0 / 5.0 * mass * pow(r_part, 2.0);
     box_size = get_real_parameter("box_size");
+    const bool rigid_clusters = get_integer_parameter("rigid_clusters") != 0;
+
+    // Pairs beyond r_verlet never enter the neighbor list, so the shifted force must already vanish inside it
+    auto hamaker_cutoff = get_real_parameter("hamaker_cutoff");
+    if (hamaker_cutoff > 0.0 && (hamaker_cutoff <= 2.0 * r_part || hamaker_cutoff >= r_verlet)) {
+        std::cerr << "hamaker_cutoff must be greater than 2 * r_part and less than r_verlet" << std::endl;
+        return false;
+    }
+
+    // Rigid clusters have no springs to resolve
+    auto dt_safety_factor = get_real_parameter("dt_safety_factor");
+    if (dt_safety_factor > 0.0 && !rigid_clusters) {
+        auto dt_stable = get_stable_time_step(mass, inertia, r_part, {{k_n, k_t, k_r, k_o}}, {}, dt_safety_factor);
+        if (dt_stable < dt) {
+            dt = dt_stable;
+            output_stream << "Time step reduced to " << dt << " to resolve the stiffest spring" << std::endl;
+        }
+    }
 
     // Declare the initial condition buffers
     std::vector<Eigen::Vector3d> x0, v0, theta0, omega0;
 
     seed_random_engine(rng_seed);
 
-    x0.resize(n_part);
+    // Give up on a particle after this many rejected positions: the box is too densely packed
+    constexpr long max_placement_attempts = 100000;
+
+    x0.reserve(n_part);
+    PlacementGrid placement_grid(box_size, r_part, n_part);
     std::uniform_real_distribution<double> x0_dist(-(box_size / 2.0 - r_part), box_size / 2.0 - r_part);
     for (long n = 0; n < n_part; n ++) {
         Eigen::Vector3d particle;
+        long attempts = 0;
         do {
+            if (attempts ++ == max_placement_attempts) {
+                std::cerr << "Unable to place particle " << n << " without overlaps, increase box_size" << std::endl;
+                return false;
+            }
             particle = {
                     x0_dist(get_random_engine()),
                     x0_dist(get_random_engine()),
                     x0_dist(get_random_engine())
             };
-        } while (particle_overlaps(particle, x0, r_part));
-        x0[n] = particle;
+        } while (placement_grid.overlaps(particle, x0, r_part));
+        placement_grid.insert(x0.size(), particle);
+        x0.emplace_back(particle);
     }
 
     // Generate initial velocities
@@ -144,27 +255,76 @@ bool AggregationSimulation::initialize(std::ostream &output_stream, std::vector<
     std::fill(theta0.begin(), theta0.end(), Eigen::Vector3d::Zero());
     std::fill(omega0.begin(), omega0.end(), Eigen::Vector3d::Zero());
 
-    contact_model = std::make_unique<contact_force_model_t >(
-            x0.size(),
-            k_n, gamma_n,
-            k_t, gamma_t, mu_t, phi_t,
-            k_r, gamma_r, mu_r, phi_r,
-            k_o, gamma_o, mu_o, phi_o,
-            r_part, mass, inertia, dt, Eigen::Vector3d::Zero(), 0.0);
+    if (rigid_clusters) {
+        // Collisions are only detected at the end of a step, so primaries must not pass through each other within one
+        if (v0_part * dt >= r_part) {
+            std::cerr << "dt is too large for rigid clusters, primaries must move less than r_part per step" << std::endl;
+            return false;
+        }
 
-    hamaker_model = std::make_unique<hamaker_force_model_t>(
-            A, h0, r_part, mass, Eigen::Vector3d::Zero(), 0.0
-    );
+        rigid_cluster_system = std::make_unique<RigidClusterSystem>(x0, v0, omega0, r_part, mass, inertia, box_size);
+        output_stream << "Integrating rigid clusters, primaries stick on contact" << std::endl;
+    } else {
+        force_model_instances = std::make_unique<force_models<force_real_type>>(*this, x0.size(), r_verlet);
+
+        auto & hamaker_table_model = force_model_instances->hamaker_table_model;
+        if (hamaker_table_model.is_tabulated()) {
+            auto table_error = hamaker_table_model.get_max_relative_error();
+            output_stream << "Tabulated Hamaker force with relative error " << table_error << std::endl;
+            if (table_error > force_table_tolerance) {
+                std::cerr << "Hamaker force table error exceeds force_table_tolerance, increase force_table_size" << std::endl;
+                return false;
+            }
+        }
 
-    binary_force_container = std::make_unique<binary_force_container_t >(*contact_model, *hamaker_model);
+        unary_force_container = std::make_unique<unary_force_container_t>();
+
+        granular_system = std::make_unique<granular_system_neighbor_list_mutable_velocity<force_real_type>>(x0.size(), r_verlet, x0,
+                                                                                                            v0, theta0, omega0, 0.0, field_type::Zero(), 0.0,
+                                                                                                            step_handler_instance, force_model_instances->binary_force_container,
+                                                                                                            *unary_force_container);
+
+        if constexpr (!std::is_same_v<force_real_type, real_type>) {
+            output_stream << "Using single precision force evaluation" << std::endl;
+
+            // Compare positions reached from the initial state with single and double precision forces
+            auto precision_check_steps = get_integer_parameter("precision_check_steps");
+            if (precision_check_steps > 0) {
+                auto x_single = integrate_initial_state<force_real_type>(x0, v0, theta0, omega0, r_verlet, precision_check_steps);
+                auto x_double = integrate_initial_state<real_type>(x0, v0, theta0, omega0, r_verlet, precision_check_steps);
+
+                double max_deviation = 0.0;
+                for (size_t i = 0; i < x_single.size(); i ++) {
+                    max_deviation = std::max(max_deviation, (x_single[i] - x_double[i]).norm());
+                }
+                max_deviation /= r_part;
+
+                output_stream << "Single precision positions deviate by up to " << max_deviation
+                              << " r_part from double precision after " << precision_check_steps << " steps" << std::endl;
+                if (max_deviation > get_real_parameter("precision_check_tolerance")) {
+                    std::cerr << "Single precision deviation exceeds precision_check_tolerance, build without USE_SINGLE_PRECISION_AGGREGATION" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
 
-    unary_force_container = std::make_unique<unary_force_container_t>();
+    if (restore_checkpoint(output_stream, r_verlet)) {
+        x0_buffer = rigid_cluster_system ? rigid_cluster_system->get_x() : granular_system->get_x();
+    }
 
-    granular_system = std::make_unique<granular_system_neighbor_list_mutable_velocity>(x0.size(), r_verlet, x0,
-                                                                                       v0, theta0, omega0, 0.0, Eigen::Vector3d::Zero(), 0.0,
-                                                                                       step_handler_instance, *binary_force_container, *unary_force_container);
     output_stream << "Dump\tTime\tKE\tRMS_disp\tRMS_force";
 
+    if (rigid_cluster_system) {
+        x_prev = rigid_cluster_system->get_x();
+        std::vector<Eigen::Vector3d> zeros(x_prev.size(), Eigen::Vector3d::Zero());
+        dump_particles(dump_directory.string(), current_step / dump_period, x_prev,
+                       rigid_cluster_system->get_v(), zeros, rigid_cluster_system->get_omega(), zeros, r_part);
+        return true;
+    }
+
+    x_prev = granular_system->get_x();
+
     dump_particles(dump_directory.string(), current_step / dump_period, granular_system->get_x(),
                    granular_system->get_v(), granular_system->get_a(),
                    granular_system->get_omega(), granular_system->get_alpha(), r_part);
@@ -173,46 +333,146 @@ bool AggregationSimulation::initialize(std::ostream &output_stream, std::vector<
 }
 
 std::tuple<std::string, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<std::vector<Eigen::Vector3d>>> AggregationSimulation::perform_iterations() {
+    TRACE_SCOPE("Simulation::perform_iterations");
 
-    std::vector<Eigen::Vector3d> x_before_iter = granular_system->get_x();
+    if (rigid_cluster_system) {
+        for (int i = 0; i < dump_period; i ++) {
+            {
+                TRACE_SCOPE("do_step");
+                rigid_cluster_system->do_step(dt);
+            }
+            current_step ++;
+        }
+
+        // Rigid clusters move freely between collisions
+        std::vector<Eigen::Vector3d> zeros(rigid_cluster_system->get_n_part(), Eigen::Vector3d::Zero());
+        return finish_dump(rigid_cluster_system->get_x(), rigid_cluster_system->get_v(), zeros,
+                           rigid_cluster_system->get_omega(), zeros);
+    }
 
     for (int i = 0; i < dump_period; i ++) {
         if (current_step % neighbor_update_period == 0) {
+            TRACE_SCOPE("update_neighbor_list");
             granular_system->update_neighbor_list();
         }
-        granular_system->do_step(dt);
+        {
+            TRACE_SCOPE("do_step");
+            granular_system->do_step(dt);
+        }
         bounce_off_walls(granular_system->get_x(), granular_system->get_v(), r_part, box_size);
         current_step ++;
     }
 
-    double rms_displacement = 0.0,
-            rms_force = 0.0;
-
-    for (int i = 0; i < x_before_iter.size(); i ++) {
-        Eigen::Vector3d displacement = x_before_iter[i] - granular_system->get_x()[i];
-        rms_displacement += displacement.dot(displacement);
-
-        Eigen::Vector3d force = granular_system->get_a()[i] * mass;
-        rms_force += force.dot(force);
-    }
+    return finish_dump(granular_system->get_x(), granular_system->get_v(), granular_system->get_a(),
+                       granular_system->get_omega(), granular_system->get_alpha());
+}
 
-    rms_displacement = sqrt(rms_displacement / double(x_before_iter.size()));
-    rms_force = sqrt(rms_force / double(x_before_iter.size()));
+std::tuple<std::string, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<std::vector<Eigen::Vector3d>>>
+AggregationSimulation::finish_dump(std::vector<Eigen::Vector3d> const & x, std::vector<Eigen::Vector3d> const & v,
+                                   std::vector<Eigen::Vector3d> const & a, std::vector<Eigen::Vector3d> const & omega,
+                                   std::vector<Eigen::Vector3d> const & alpha) {
+    auto [ke, rms_displacement, rms_force] = compute_dump_diagnostics(x_prev, x, v, a, omega, mass, inertia);
 
     std::stringstream message_out;
     auto fmt = format_string(
             "{}\t{:.1e}\t{:.2e}\t{:.2e}\t{:.2e}",   // format string
             current_step / dump_period,  // dump number
             double(current_step) * dt,  // time
-            compute_ke(granular_system->get_v(), granular_system->get_omega(), mass, inertia),  // total kinetic energy
+            ke,  // total kinetic energy
             rms_displacement,   // rms displacement of particles from the last dump
             rms_force   // rms force acting on particles
     );
     message_out << fmt;
 
-    dump_particles(dump_directory.string(), current_step / dump_period, granular_system->get_x(),
-                   granular_system->get_v(), granular_system->get_a(),
-                   granular_system->get_omega(), granular_system->get_alpha(), r_part);
+    {
+        TRACE_SCOPE("dump");
+        dump_particles(dump_directory.string(), current_step / dump_period, x, v, a, omega, alpha, r_part);
+    }
 
-    return {message_out.str(), granular_system->get_x(), {}, {}, {}};
+    if (checkpoint_period > 0 && (current_step / dump_period) % checkpoint_period == 0) {
+        try {
+            write_checkpoint();
+        } catch (UiException const & e) {
+            message_out << "\n" << e.what();
+        }
+    }
+
+    return {message_out.str(), x, {}, {}, {}};
+}
+
+void AggregationSimulation::write_checkpoint() const {
+    TRACE_SCOPE("write_checkpoint");
+
+    CheckpointWriter writer(get_checkpoint_path(), config_file_signature, get_parameter_fingerprint());
+    writer.write(current_step);
+    if (rigid_cluster_system) {
+        // Clusters are rebuilt from the touching primaries on restore
+        writer.write(rigid_cluster_system->get_x());
+        writer.write(rigid_cluster_system->get_v());
+        writer.write(std::vector<Eigen::Vector3d>(rigid_cluster_system->get_n_part(), Eigen::Vector3d::Zero()));
+        writer.write(rigid_cluster_system->get_omega());
+    } else {
+        writer.write(granular_system->get_x());
+        writer.write(granular_system->get_v());
+        writer.write(granular_system->get_theta());
+        writer.write(granular_system->get_omega());
+    }
+
+    std::stringstream rng_state;
+    rng_state << get_random_engine();
+    writer.write(rng_state.str());
+    writer.commit();
+}
+
+// Replaces the freshly initialized state with the state stored in the checkpoint, if one exists and resuming was requested
+bool AggregationSimulation::restore_checkpoint(std::ostream & output_stream, double r_verlet) {
+    if (!resume_checkpoint || !std::filesystem::exists(get_checkpoint_path()))
+        return false;
+
+    size_t step;
+    std::vector<Eigen::Vector3d> x, v, theta, omega;
+    std::string rng_state;
+
+    try {
+        CheckpointReader reader(get_checkpoint_path(), config_file_signature);
+        if (reader.get_parameter_fingerprint() != get_parameter_fingerprint()) {
+            output_stream << "Checkpoint was written with different parameters, starting a new run" << std::endl;
+            return false;
+        }
+
+        reader.read(step);
+        reader.read(x);
+        reader.read(v);
+        reader.read(theta);
+        reader.read(omega);
+        reader.read(rng_state);
+
+        size_t n_part = rigid_cluster_system ? rigid_cluster_system->get_n_part() : granular_system->get_x().size();
+        if (x.size() != n_part)
+            throw UiException("Checkpoint does not match the initialized system");
+    } catch (UiException const & e) {
+        output_stream << "Unable to resume from checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+
+    current_step = step;
+    std::stringstream(rng_state) >> get_random_engine();
+
+    if (rigid_cluster_system) {
+        rigid_cluster_system = std::make_unique<RigidClusterSystem>(x, v, omega, r_part, mass, inertia, box_size);
+        output_stream << "Resumed from checkpoint at step " << current_step << std::endl;
+        return true;
+    }
+
+    granular_system = std::make_unique<granular_system_neighbor_list_mutable_velocity<force_real_type>>(x.size(), r_verlet, x,
+                                                                                                        v, theta, omega, double(current_step) * dt, field_type::Zero(), 0.0,
+                                                                                                        step_handler_instance, force_model_instances->binary_force_container,
+                                                                                                        *unary_force_container);
+
+    output_stream << "Resumed from checkpoint at step " << current_step << std::endl;
+    // soot-dem and libgran do not expose the spring history of their force models
+    output_stream << "Warning: checkpoints do not store contact spring history, all tangential, rolling and torsional "
+                     "springs were reset to zero extension and the resumed run will not reproduce an uninterrupted one" << std::endl;
+
+    return true;
 }
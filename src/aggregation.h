@@ -42,21 +42,59 @@
 #include <break_neck.h>
 
 #include "simulation.h"
+#include "dump_diagnostics.h"
+#include "checkpoint.h"
+#include "precision.h"
+#include "tabulated_force.h"
+#include "cutoff_force.h"
+#include "rigid_clusters.h"
 
 class AggregationSimulation : public Simulation {
 public:
-    using contact_force_model_t = contact_force_functor<Eigen::Vector3d, double>;
-    using hamaker_force_model_t = hamaker_functor<Eigen::Vector3d, double>;
-    using binary_force_container_t = binary_force_functor_container<Eigen::Vector3d, double, contact_force_model_t, hamaker_force_model_t>;
-    using unary_force_container_t = unary_force_functor_container<Eigen::Vector3d, double>;
-    using granular_system_t = granular_system_neighbor_list<Eigen::Vector3d, double, rotational_velocity_verlet_half,
-            rotational_step_handler, binary_force_container_t, unary_force_container_t>;
-
-    class granular_system_neighbor_list_mutable_velocity : public granular_system_t {
+    // Positions, velocities, and orientations are always integrated in double precision.
+    // With USE_SINGLE_PRECISION_AGGREGATION, the contact and Hamaker forces are evaluated in float
+    using real_type = double;
+    using field_type = Eigen::Vector3d;
+#ifdef USE_SINGLE_PRECISION_AGGREGATION
+    using force_real_type = float;
+#else //USE_SINGLE_PRECISION_AGGREGATION
+    using force_real_type = double;
+#endif //USE_SINGLE_PRECISION_AGGREGATION
+
+    using unary_force_container_t = unary_force_functor_container<field_type, real_type>;
+
+    // Pair force models evaluated in force_real_t precision on the double precision state
+    template<typename force_real_t>
+    struct force_models {
+        using force_field_t = Eigen::Matrix<force_real_t, 3, 1>;
+        using contact_force_model_t = contact_force_functor<force_field_t, force_real_t>;
+        using hamaker_force_model_t = hamaker_functor<force_field_t, force_real_t>;
+        using hamaker_table_model_t = tabulated_force_functor<force_field_t, force_real_t, hamaker_force_model_t>;
+        using hamaker_cutoff_model_t = cutoff_force_functor<force_field_t, force_real_t, hamaker_table_model_t>;
+        using contact_precision_model_t = mixed_precision_force_functor<field_type, real_type, force_field_t, force_real_t, contact_force_model_t>;
+        using hamaker_precision_model_t = mixed_precision_force_functor<field_type, real_type, force_field_t, force_real_t, hamaker_cutoff_model_t>;
+        using binary_force_container_t = binary_force_functor_container<field_type, real_type, contact_precision_model_t, hamaker_precision_model_t>;
+
+        force_models(AggregationSimulation const & simulation, size_t n_part, double r_verlet);
+
+        contact_force_model_t contact_model;
+        hamaker_force_model_t hamaker_model;
+        hamaker_table_model_t hamaker_table_model;
+        hamaker_cutoff_model_t hamaker_cutoff_model;
+        contact_precision_model_t contact_precision_model;
+        hamaker_precision_model_t hamaker_precision_model;
+        binary_force_container_t binary_force_container;
+    };
+
+    template<typename force_real_t>
+    class granular_system_neighbor_list_mutable_velocity : public granular_system_neighbor_list<field_type, real_type,
+            rotational_velocity_verlet_half, rotational_step_handler,
+            typename force_models<force_real_t>::binary_force_container_t, unary_force_container_t> {
     public:
-        using granular_system_t::granular_system_neighbor_list;
+        using granular_system_neighbor_list<field_type, real_type, rotational_velocity_verlet_half, rotational_step_handler,
+                typename force_models<force_real_t>::binary_force_container_t, unary_force_container_t>::granular_system_neighbor_list;
 
-        std::vector<Eigen::Vector3d> & get_v() {
+        std::vector<field_type> & get_v() {
             return this->v;
         }
     };
@@ -127,11 +165,14 @@ public:
             {"box_size", REAL, "Simulation box size"},
             {"d_crit", REAL, "Critical separation for a contact"},
             {"dt", REAL, "Integration time step"},
+            {"dt_safety_factor", REAL, "Upper bound for dt as a fraction of the critical time step (0 to disable)"},
+            {"force_table_tolerance", REAL, "Largest allowed relative error of the tabulated Hamaker force"},
             {"gamma_n", REAL, "Normal damping coefficient"},
             {"gamma_o", REAL, "Torsional damping coefficient"},
             {"gamma_r", REAL, "Rotational damping coefficient"},
             {"gamma_t", REAL, "Tangential damping coefficient"},
             {"h0", REAL, "Hamaker saturation distance"},
+            {"hamaker_cutoff", REAL, "Center-to-center distance beyond which the Hamaker force is neglected, the force is shifted to vanish there (0 to disable, otherwise between 2 * r_part and r_verlet)"},
             {"k_n", REAL, "Normal stiffness coefficient"},
             {"k_o", REAL, "Torsional stiffness coefficient"},
             {"k_r", REAL, "Rolling stiffness coefficient"},
@@ -142,13 +183,19 @@ public:
             {"phi_o", REAL, "Torsional dynamic to static friction ratio"},
             {"phi_r", REAL, "Rolling dynamic to static friction ratio"},
             {"phi_t", REAL, "Tangential dynamic to static friction ratio"},
+            {"precision_check_tolerance", REAL, "Largest allowed deviation of single precision positions, in r_part"},
             {"r_part", REAL, "Primary particle radius"},
             {"r_verlet", REAL, "Verlet radius"},
             {"rho", REAL, "Density"},
             {"v0_part", REAL, "Initial velocity of particles"},
+            {"checkpoint_period", INTEGER, "Checkpoint period in dumps (0 to disable)"},
             {"dump_period", INTEGER, "Dump period"},
+            {"force_table_size", INTEGER, "Number of points in the Hamaker force table (0 to use the analytic form)"},
             {"n_part", INTEGER, "Number of particles"},
             {"neighbor_update_period", INTEGER, "Neighbor list update period"},
+            {"precision_check_steps", INTEGER, "Steps over which single precision forces are compared with double precision on initialization (0 to disable, single precision builds only)"},
+            {"resume_checkpoint", INTEGER, "Resume from the last checkpoint on initialization (0 / 1)"},
+            {"rigid_clusters", INTEGER, "Merge colliding primaries into rigid clusters instead of resolving contacts (0 / 1)"},
             {"rng_seed", INTEGER, "Random number generator seed"},
     };
     static constexpr size_t N_PARAMETERS = sizeof(PARAMETERS) / sizeof(PARAMETERS[0]);
@@ -156,15 +203,27 @@ public:
 
 
 private:
+    void write_checkpoint() const;
+    bool restore_checkpoint(std::ostream & output_stream, double r_verlet);
+    std::tuple<std::string, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<std::vector<Eigen::Vector3d>>>
+    finish_dump(std::vector<Eigen::Vector3d> const & x, std::vector<Eigen::Vector3d> const & v, std::vector<Eigen::Vector3d> const & a,
+                std::vector<Eigen::Vector3d> const & omega, std::vector<Eigen::Vector3d> const & alpha);
+
+    template<typename force_real_t>
+    std::vector<Eigen::Vector3d> integrate_initial_state(std::vector<Eigen::Vector3d> const & x0, std::vector<Eigen::Vector3d> const & v0,
+                                                         std::vector<Eigen::Vector3d> const & theta0, std::vector<Eigen::Vector3d> const & omega0,
+                                                         double r_verlet, long n_steps) const;
+
     double mass, inertia, r_part, dt, box_size;
-    long dump_period, neighbor_update_period;
+    long dump_period, neighbor_update_period, checkpoint_period;
+    bool resume_checkpoint;
     size_t current_step = 0;
-    std::unique_ptr<contact_force_model_t> contact_model;
-    std::unique_ptr<hamaker_force_model_t> hamaker_model;
+    std::vector<Eigen::Vector3d> x_prev; // Particle positions at the previous dump
+    std::unique_ptr<force_models<force_real_type>> force_model_instances;
     std::unique_ptr<unary_force_container_t> unary_force_container;
-    std::unique_ptr<binary_force_container_t> binary_force_container;
-    std::unique_ptr<granular_system_neighbor_list_mutable_velocity> granular_system;
-    rotational_step_handler<std::vector<Eigen::Vector3d>, Eigen::Vector3d> step_handler_instance;
+    std::unique_ptr<granular_system_neighbor_list_mutable_velocity<force_real_type>> granular_system;
+    std::unique_ptr<RigidClusterSystem> rigid_cluster_system; // Replaces the granular system if rigid clusters are enabled
+    rotational_step_handler<std::vector<field_type>, field_type> step_handler_instance;
 };
 
 #endif //GUI_DESIGN_SOOT_DEM_AGGREGATION_H
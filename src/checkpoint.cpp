@@ -0,0 +1,208 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#include "checkpoint.h"
+
+static constexpr char CHECKPOINT_MAGIC[8] = {'S', 'D', 'E', 'M', 'C', 'K', 'P', 'T'};
+static constexpr size_t CHECKPOINT_VERSION = 1;
+
+// Several processes may write the same file concurrently (e.g. an aggregate cache shared by a parameter sweep),
+// so each writer gets its own temporary file in the target directory and the last rename wins
+static std::filesystem::path get_temporary_path(std::filesystem::path const & path) {
+    std::random_device device;
+    std::stringstream ss;
+    ss << path.string() << '.' << std::hex << device() << device() << ".tmp";
+    return ss.str();
+}
+
+CheckpointWriter::CheckpointWriter(std::filesystem::path const & path,
+                                   std::string const & config_signature,
+                                   std::string const & parameter_fingerprint)
+    : path{path}
+    , temporary_path{get_temporary_path(path)}
+    , out{temporary_path, std::ios::binary | std::ios::trunc} {
+
+    if (!out.good())
+        throw UiException("Unable to open checkpoint file `" + temporary_path.string() + "` for writing");
+
+    out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    write(CHECKPOINT_VERSION);
+    write(config_signature);
+    write(parameter_fingerprint);
+}
+
+void CheckpointWriter::write(size_t value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void CheckpointWriter::write(double value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void CheckpointWriter::write(std::string const & value) {
+    write(value.size());
+    out.write(value.data(), std::streamsize(value.size()));
+}
+
+void CheckpointWriter::write(std::vector<double> const & values) {
+    write(values.size());
+    out.write(reinterpret_cast<const char *>(values.data()), std::streamsize(values.size() * sizeof(double)));
+}
+
+void CheckpointWriter::write(std::vector<bool> const & values) {
+    // std::vector<bool> is bit-packed and has no contiguous storage, pack it into bytes
+    std::vector<char> packed((values.size() + 7) / 8, 0);
+    for (size_t n = 0; n < values.size(); n ++) {
+        if (values[n])
+            packed[n / 8] |= char(1u << (n % 8));
+    }
+    write(values.size());
+    out.write(packed.data(), std::streamsize(packed.size()));
+}
+
+void CheckpointWriter::write(std::vector<Eigen::Vector3d> const & values) {
+    write(values.size());
+    for (auto const & value : values) {
+        out.write(reinterpret_cast<const char *>(value.data()), 3 * sizeof(double));
+    }
+}
+
+void CheckpointWriter::commit() {
+    out.flush();
+    bool ok = out.good();
+    out.close();
+
+    std::error_code ec;
+    if (!ok) {
+        std::filesystem::remove(temporary_path, ec);
+        throw UiException("Unable to write checkpoint file `" + temporary_path.string() + "`");
+    }
+
+    std::filesystem::rename(temporary_path, path, ec);
+    if (ec) {
+        std::error_code remove_ec;
+        std::filesystem::remove(temporary_path, remove_ec);
+        throw UiException("Unable to replace checkpoint file `" + path.string() + "`: " + ec.message());
+    }
+}
+
+CheckpointReader::CheckpointReader(std::filesystem::path const & path,
+                                   std::string const & config_signature)
+    : in{path, std::ios::binary} {
+
+    if (!in.good())
+        throw UiException("Unable to open checkpoint file `" + path.string() + "`");
+
+    std::error_code ec;
+    file_size = std::filesystem::file_size(path, ec);
+    if (ec)
+        throw UiException("Unable to determine the size of checkpoint file `" + path.string() + "`");
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in.good() || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0)
+        throw UiException("Checkpoint file corrupt - invalid header");
+
+    size_t version;
+    read(version);
+    if (version != CHECKPOINT_VERSION)
+        throw UiException("Checkpoint file version " + std::to_string(version) + " is not supported");
+
+    std::string signature;
+    read(signature);
+    if (signature != config_signature)
+        throw UiException("Checkpoint file was written by a `" + signature + "` simulation");
+
+    read(parameter_fingerprint);
+}
+
+std::string const & CheckpointReader::get_parameter_fingerprint() const {
+    return parameter_fingerprint;
+}
+
+void CheckpointReader::check_remaining(size_t size, size_t element_size) {
+    auto position = in.tellg();
+    if (position < 0)
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+    // Guards the allocations below against sizes read from a truncated or corrupt file
+    size_t remaining = file_size - std::min(file_size, size_t(position));
+    if (size > remaining / element_size)
+        throw UiException("Checkpoint file corrupt - stored size exceeds the file size");
+}
+
+void CheckpointReader::read(size_t & value) {
+    in.read(reinterpret_cast<char *>(&value), sizeof(value));
+    if (!in.good())
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+}
+
+void CheckpointReader::read(double & value) {
+    in.read(reinterpret_cast<char *>(&value), sizeof(value));
+    if (!in.good())
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+}
+
+void CheckpointReader::read(std::string & value) {
+    size_t size;
+    read(size);
+    check_remaining(size, 1);
+    value.resize(size);
+    in.read(value.data(), std::streamsize(size));
+    if (!in.good())
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+}
+
+void CheckpointReader::read(std::vector<double> & values) {
+    size_t size;
+    read(size);
+    check_remaining(size, sizeof(double));
+    values.resize(size);
+    in.read(reinterpret_cast<char *>(values.data()), std::streamsize(size * sizeof(double)));
+    if (!in.good())
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+}
+
+void CheckpointReader::read(std::vector<bool> & values) {
+    size_t size;
+    read(size);
+    check_remaining(size / 8 + (size % 8 != 0), 1);
+    std::vector<char> packed(size / 8 + (size % 8 != 0));
+    in.read(packed.data(), std::streamsize(packed.size()));
+    if (!in.good())
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+
+    values.resize(size);
+    for (size_t n = 0; n < size; n ++) {
+        values[n] = (packed[n / 8] >> (n % 8)) & 1;
+    }
+}
+
+void CheckpointReader::read(std::vector<Eigen::Vector3d> & values) {
+    size_t size;
+    read(size);
+    check_remaining(size, 3 * sizeof(double));
+    values.resize(size);
+    for (auto & value : values) {
+        in.read(reinterpret_cast<char *>(value.data()), 3 * sizeof(double));
+    }
+    if (!in.good())
+        throw UiException("Checkpoint file corrupt - unexpected end of file");
+}
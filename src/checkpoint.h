@@ -0,0 +1,80 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_CHECKPOINT_H
+#define SOOT_DEM_GUI_CHECKPOINT_H
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include "exceptions.h"
+
+// Binary checkpoint files store values in the native byte order and are meant to be
+// read back on the same platform. Every file starts with a header containing the
+// simulation config signature and a fingerprint of the parameters it was produced with
+
+// Writes a checkpoint into a uniquely named temporary file next to the destination.
+// The destination is only replaced (atomically, by renaming) when commit() succeeds,
+// so an interrupted write never corrupts the previous checkpoint
+class CheckpointWriter {
+public:
+    CheckpointWriter(std::filesystem::path const & path,
+                     std::string const & config_signature,
+                     std::string const & parameter_fingerprint);
+
+    void write(size_t value);
+    void write(double value);
+    void write(std::string const & value);
+    void write(std::vector<double> const & values);
+    void write(std::vector<bool> const & values);
+    void write(std::vector<Eigen::Vector3d> const & values);
+
+    void commit();
+
+private:
+    std::filesystem::path path, temporary_path;
+    std::ofstream out;
+};
+
+class CheckpointReader {
+public:
+    // Throws UiException if the file cannot be read or was produced by a different simulation type
+    CheckpointReader(std::filesystem::path const & path,
+                     std::string const & config_signature);
+
+    std::string const & get_parameter_fingerprint() const;
+
+    void read(size_t & value);
+    void read(double & value);
+    void read(std::string & value);
+    void read(std::vector<double> & values);
+    void read(std::vector<bool> & values);
+    void read(std::vector<Eigen::Vector3d> & values);
+
+private:
+    // Throws UiException if fewer than size * element_size bytes are left in the file
+    void check_remaining(size_t size, size_t element_size);
+
+    std::ifstream in;
+    std::string parameter_fingerprint;
+    size_t file_size;
+};
+
+#endif //SOOT_DEM_GUI_CHECKPOINT_H
@@ -19,6 +19,7 @@
 #include <chrono>
 
 #include "compute_thread.h"
+#include "trace.h"
 
 ComputeThread::ComputeThread(QObject * parent)
     : QThread(parent) {}
@@ -99,12 +100,15 @@ void ComputeThread::do_terminate() {
 }
 
 void ComputeThread::run() {
+    TRACE_THREAD_NAME("compute");
+
     forever {
         mutex.lock();
         auto current_state = worker_state;
         mutex.unlock();
 
         if (current_state == ADVANCE_ONE || current_state == ADVANCE_CONTINUOUS) {
+            TRACE_SCOPE("ComputeThread::run");
             auto [message, x, neck_positions, neck_orientations, polygons] = simulation->perform_iterations();
             QVector<QVector<Eigen::Vector3d>> polygons_qvector;
             polygons_qvector.resize(polygons.size());
@@ -118,7 +122,14 @@ void ComputeThread::run() {
                            QVector<Eigen::Vector3d>(neck_orientations.begin(), neck_orientations.end()),
                            polygons_qvector);
 
-            if (current_state == ADVANCE_ONE) {
+            if (simulation->is_finished()) {
+                // The run has converged, stop advancing it without waiting for a pause request
+                mutex.lock();
+                if (worker_state != ABORT)
+                    worker_state = PAUSE;
+                mutex.unlock();
+                emit simulation_finished(QString::fromStdString(simulation->get_finish_reason()));
+            } else if (current_state == ADVANCE_ONE) {
                 mutex.lock();
                 worker_state = PAUSE;
                 mutex.unlock();
@@ -49,6 +49,7 @@ signals:
                    QVector<Eigen::Vector3d> const & neck_orientations_buffer,
                    QVector<QVector<Eigen::Vector3d>> const & polygons);
     void pause_done();
+    void simulation_finished(QString const & reason);
 
 protected:
     void run() override;
@@ -0,0 +1,70 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_CUTOFF_FORCE_H
+#define SOOT_DEM_GUI_CUTOFF_FORCE_H
+
+#include <vector>
+#include <utility>
+#include <cmath>
+
+// Restricts a central binary force functor that only depends on the distance between the two particles to pairs
+// closer than its own cutoff distance, so that a long neighbor list shared with other interactions does not evaluate it
+// for pairs that it should ignore. Inside the cutoff, the force is shifted by its value at the cutoff, so it vanishes
+// continuously there instead of jumping to zero when a pair crosses the cutoff.
+// Only suitable for functors without per-pair state (the wrapped functor is not called for skipped pairs).
+// A cutoff of zero or less disables the check and the shift
+template<typename field_type, typename real_type, typename functor_t>
+class cutoff_force_functor {
+public:
+    cutoff_force_functor(functor_t & functor, real_type cutoff)
+        : functor{functor}
+        , cutoff_sq{cutoff > 0 ? cutoff * cutoff : real_type(-1)} {
+
+        if (cutoff <= 0)
+            return;
+
+        // Component of the acceleration of particle i along the direction towards particle j at the cutoff
+        std::vector<field_type> x_pair {field_type::Zero(), cutoff * field_type::UnitX()};
+        std::vector<field_type> zeros(2, field_type::Zero());
+        shift = functor(0, 1, x_pair, zeros, zeros, zeros, 0).first[0];
+    }
+
+    std::pair<field_type, field_type> operator () (size_t i, size_t j,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        if (cutoff_sq <= 0)
+            return functor(i, j, x, v, theta, omega, t);
+
+        field_type r_ij = x[j] - x[i];
+        real_type r_sq = r_ij.squaredNorm();
+        if (r_sq >= cutoff_sq)
+            return {field_type::Zero(), field_type::Zero()};
+
+        auto [a, alpha] = functor(i, j, x, v, theta, omega, t);
+        return {a - shift / std::sqrt(r_sq) * r_ij, alpha};
+    }
+
+private:
+    functor_t & functor;
+    const real_type cutoff_sq;
+    real_type shift = 0;
+};
+
+#endif //SOOT_DEM_GUI_CUTOFF_FORCE_H
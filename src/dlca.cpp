@@ -0,0 +1,286 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include "format_wrapper.h"
+
+#include "trace.h"
+#include "dlca.h"
+
+// Isotropic direction of a random walk step
+static Eigen::Vector3d get_random_direction() {
+    std::normal_distribution<double> dist(0.0, 1.0);
+    Eigen::Vector3d vec;
+    do {
+        vec = {
+                dist(get_random_engine()),
+                dist(get_random_engine()),
+                dist(get_random_engine())
+        };
+    } while (vec.norm() == 0);
+    return vec.normalized();
+}
+
+DlcaSimulation::DlcaSimulation(
+        parameter_heap_t const & parameter_heap,
+        std::filesystem::path const & working_directory
+) : Simulation(parameter_heap, working_directory) {}
+
+bool DlcaSimulation::initialize(std::ostream & output_stream, std::vector<Eigen::Vector3d> & x0_buffer,
+                                std::vector<Eigen::Vector3d> & neck_positions_buffer [[maybe_unused]],
+                                std::vector<Eigen::Vector3d> & neck_orientations_buffer [[maybe_unused]],
+                                std::vector<std::vector<Eigen::Vector3d>> & polygons [[maybe_unused]]) {
+    TRACE_SCOPE("Simulation::initialize");
+
+    auto rng_seed = get_integer_parameter("rng_seed");
+    const long n_part = get_integer_parameter("n_part");
+
+    r_part = get_real_parameter("r_part");
+    box_size = get_real_parameter("box_size");
+    step_size = get_real_parameter("step_size");
+    mobility_exponent = get_real_parameter("mobility_exponent");
+    dump_period = get_integer_parameter("dump_period");
+
+    if (step_size <= 0.0 || step_size > r_part) {
+        std::cerr << "step_size must be positive and at most r_part" << std::endl;
+        return false;
+    }
+
+    if (mobility_exponent > 0.0) {
+        std::cerr << "mobility_exponent must not be positive" << std::endl;
+        return false;
+    }
+
+    // A primary can only reach the primaries in its own and the adjacent cells within one step.
+    // With at least three cells per side, the adjacent cells are distinct across the periodic boundaries
+    n_cells = long(box_size / (2.0 * r_part + step_size));
+    if (n_cells < 3) {
+        std::cerr << "box_size must be at least three primary diameters" << std::endl;
+        return false;
+    }
+    cell_size = box_size / double(n_cells);
+    cells.resize(n_cells * n_cells * n_cells);
+
+    seed_random_engine(rng_seed);
+
+    // Give up on a particle after this many rejected positions: the box is too densely packed
+    constexpr long max_placement_attempts = 100000;
+
+    std::uniform_real_distribution<double> x0_dist(-box_size / 2.0, box_size / 2.0);
+    for (long n = 0; n < n_part; n ++) {
+        Eigen::Vector3d particle;
+        long attempts = 0;
+        do {
+            if (attempts ++ == max_placement_attempts) {
+                std::cerr << "Unable to place particle " << n << " without overlaps, increase box_size" << std::endl;
+                return false;
+            }
+            particle = {
+                    x0_dist(get_random_engine()),
+                    x0_dist(get_random_engine()),
+                    x0_dist(get_random_engine())
+            };
+        } while (overlaps(particle));
+
+        cells[get_cell(particle)].emplace_back(x.size());
+        cluster_of.emplace_back(clusters.size());
+        active_clusters.emplace_back(clusters.size());
+        clusters.emplace_back(std::vector<size_t>{x.size()});
+        x.emplace_back(particle);
+    }
+
+    x0_buffer = x;
+
+    output_stream << "Dump\tMoves\tClusters\tLargest";
+
+    write_dump();
+
+    return true;
+}
+
+std::tuple<std::string, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<std::vector<Eigen::Vector3d>>> DlcaSimulation::perform_iterations() {
+    TRACE_SCOPE("Simulation::perform_iterations");
+
+    std::uniform_real_distribution<double> acceptance_dist(0.0, 1.0);
+
+    for (long i = 0; i < dump_period && !is_finished(); i ++) {
+        std::uniform_int_distribution<size_t> cluster_dist(0, active_clusters.size() - 1);
+        size_t cluster = active_clusters[cluster_dist(get_random_engine())];
+
+        // Larger clusters diffuse slower: a move is accepted with the ratio of their mobility to that of the smallest cluster
+        double acceptance = std::pow(double(clusters[cluster].size()) / double(smallest_cluster_size), mobility_exponent);
+        if (acceptance_dist(get_random_engine()) < acceptance)
+            move_cluster(cluster);
+
+        n_moves ++;
+    }
+
+    size_t largest_cluster_size = 0;
+    for (size_t cluster : active_clusters) {
+        largest_cluster_size = std::max(largest_cluster_size, clusters[cluster].size());
+    }
+
+    n_dumps ++;
+
+    std::stringstream message_out;
+    auto fmt = format_string(
+            "{}\t{}\t{}\t{}",   // format string
+            n_dumps,  // dump number
+            n_moves,  // attempted cluster moves
+            active_clusters.size(),  // number of clusters
+            largest_cluster_size  // number of primaries in the largest cluster
+    );
+    message_out << fmt;
+
+    write_dump();
+
+    return {message_out.str(), x, {}, {}, {}};
+}
+
+bool DlcaSimulation::is_finished() const {
+    return active_clusters.size() <= 1;
+}
+
+bool DlcaSimulation::can_finish() const {
+    return true;
+}
+
+std::string DlcaSimulation::get_finish_reason() const {
+    return "All primaries joined a single aggregate";
+}
+
+long DlcaSimulation::get_cell(Eigen::Vector3d const & position) const {
+    std::array<long, 3> cell;
+    for (long dim = 0; dim < 3; dim ++) {
+        double wrapped = position[dim] + box_size / 2.0 - box_size * std::floor((position[dim] + box_size / 2.0) / box_size);
+        cell[dim] = std::clamp(long(wrapped / cell_size), 0l, n_cells - 1);
+    }
+    return (cell[0] * n_cells + cell[1]) * n_cells + cell[2];
+}
+
+std::vector<long> DlcaSimulation::get_neighbor_cells(long cell) const {
+    const long cx = cell / (n_cells * n_cells), cy = cell / n_cells % n_cells, cz = cell % n_cells;
+    std::vector<long> neighbors;
+    neighbors.reserve(27);
+    for (long dx = -1; dx <= 1; dx ++) {
+        for (long dy = -1; dy <= 1; dy ++) {
+            for (long dz = -1; dz <= 1; dz ++) {
+                neighbors.emplace_back((((cx + dx + n_cells) % n_cells) * n_cells
+                        + (cy + dy + n_cells) % n_cells) * n_cells + (cz + dz + n_cells) % n_cells);
+            }
+        }
+    }
+    return neighbors;
+}
+
+Eigen::Vector3d DlcaSimulation::get_minimum_image(Eigen::Vector3d const & r) const {
+    return r - box_size * (r / box_size).array().round().matrix();
+}
+
+bool DlcaSimulation::overlaps(Eigen::Vector3d const & position) const {
+    for (long cell : get_neighbor_cells(get_cell(position))) {
+        for (size_t j : cells[cell]) {
+            if (get_minimum_image(x[j] - position).norm() < 2.0 * r_part)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Moves the cluster by one step in a random direction, stopping at the first contact with another cluster
+void DlcaSimulation::move_cluster(size_t cluster) {
+    const Eigen::Vector3d direction = get_random_direction();
+
+    double t_contact = step_size;
+    size_t hit_cluster = cluster;
+    Eigen::Vector3d hit_shift;
+
+    for (size_t i : clusters[cluster]) {
+        for (long cell : get_neighbor_cells(get_cell(x[i]))) {
+            for (size_t j : cells[cell]) {
+                if (cluster_of[j] == cluster)
+                    continue;
+
+                // Smallest t for which |t * direction - r| = 2 * r_part, if the primaries approach each other
+                Eigen::Vector3d r = get_minimum_image(x[j] - x[i]);
+                double b = direction.dot(r);
+                double discriminant = b * b - r.squaredNorm() + 4.0 * r_part * r_part;
+                if (b <= 0.0 || discriminant < 0.0)
+                    continue;
+
+                double t = std::max(b - std::sqrt(discriminant), 0.0);
+                if (t < t_contact) {
+                    t_contact = t;
+                    hit_cluster = cluster_of[j];
+                    hit_shift = r - (x[j] - x[i]); // Periodic image of the hit primary that is touched
+                }
+            }
+        }
+    }
+
+    for (size_t i : clusters[cluster]) {
+        long old_cell = get_cell(x[i]);
+        x[i] += t_contact * direction;
+        long new_cell = get_cell(x[i]);
+        if (new_cell != old_cell) {
+            auto & old_members = cells[old_cell];
+            old_members.erase(std::find(old_members.begin(), old_members.end(), i));
+            cells[new_cell].emplace_back(i);
+        }
+    }
+
+    if (hit_cluster != cluster)
+        merge_clusters(hit_cluster, cluster, hit_shift);
+}
+
+// Merges the smaller of the two clusters into the larger one.
+// The shift moves the first cluster into the periodic image in which it touches the second one
+void DlcaSimulation::merge_clusters(size_t first, size_t second, Eigen::Vector3d const & shift) {
+    size_t kept = first, removed = second;
+    Eigen::Vector3d removed_shift = -shift;
+    if (clusters[first].size() < clusters[second].size()) {
+        std::swap(kept, removed);
+        removed_shift = shift;
+    }
+
+    // The shift is a whole number of box sizes, so the wrapped positions and the cells stay the same
+    for (size_t i : clusters[removed]) {
+        x[i] += removed_shift;
+        cluster_of[i] = kept;
+    }
+    clusters[kept].insert(clusters[kept].end(), clusters[removed].begin(), clusters[removed].end());
+    clusters[removed].clear();
+    clusters[removed].shrink_to_fit();
+
+    active_clusters.erase(std::find(active_clusters.begin(), active_clusters.end(), removed));
+
+    smallest_cluster_size = clusters[active_clusters.front()].size();
+    for (size_t cluster : active_clusters) {
+        smallest_cluster_size = std::min(smallest_cluster_size, clusters[cluster].size());
+    }
+}
+
+void DlcaSimulation::write_dump() const {
+    TRACE_SCOPE("dump");
+
+    std::vector<Eigen::Vector3d> zeros(x.size(), Eigen::Vector3d::Zero());
+    dump_particles(dump_directory.string(), n_dumps, x, zeros, zeros, zeros, zeros, r_part);
+}
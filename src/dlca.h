@@ -0,0 +1,103 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SOOT_DEM_GUI_DLCA_H
+#define SOOT_DEM_GUI_DLCA_H
+
+#include <iostream>
+#include <vector>
+#include <filesystem>
+
+#include <Eigen/Eigen>
+
+#include <writer.h>
+#include <random_engine.h>
+
+#include "simulation.h"
+
+class DlcaSimulation : public Simulation {
+public:
+    explicit DlcaSimulation(
+            parameter_heap_t const & parameter_heap,
+            std::filesystem::path const & working_directory
+    );
+
+    bool initialize(std::ostream & output_stream,
+                    std::vector<Eigen::Vector3d> & x0_buffer,
+                    std::vector<Eigen::Vector3d> & neck_positions_buffer,
+                    std::vector<Eigen::Vector3d> & neck_orientations_buffer,
+                    std::vector<std::vector<Eigen::Vector3d>> & polygons) override;
+
+    std::tuple<
+        std::string,
+        std::vector<Eigen::Vector3d>,
+        std::vector<Eigen::Vector3d>,
+        std::vector<Eigen::Vector3d>,
+        std::vector<std::vector<Eigen::Vector3d>>> perform_iterations() override;
+
+    bool is_finished() const override;
+    bool can_finish() const override;
+    std::string get_finish_reason() const override;
+
+    static constexpr const char * config_file_signature = "gui_dlca";
+    static constexpr const char * combo_label = "Aggregation - Monte Carlo DLCA";
+    static constexpr unsigned int combo_id = 5;
+
+    static constexpr const char * DESCRIPTION = "Primary particles are placed at random\n"
+                                                "in a periodic box. Clusters perform\n"
+                                                "random walks with a mobility that\n"
+                                                "decreases with their size and stick\n"
+                                                "irreversibly on contact.\n\n"
+                                                "This generates aggregates by off-lattice\n"
+                                                "diffusion-limited cluster-cluster\n"
+                                                "aggregation. The last dump can be loaded\n"
+                                                "by the other simulations with\n"
+                                                "aggregate_type set to vtk.";
+
+    static constexpr std::tuple<const char *, ParameterType, const char *> PARAMETERS[] {
+            {"box_size", REAL, "Periodic box size"},
+            {"mobility_exponent", REAL, "Exponent of the cluster mobility in the number of primaries (0 or less)"},
+            {"r_part", REAL, "Primary particle radius"},
+            {"step_size", REAL, "Random walk step length (at most r_part)"},
+            {"dump_period", INTEGER, "Number of attempted cluster moves between dumps"},
+            {"n_part", INTEGER, "Number of particles"},
+            {"rng_seed", INTEGER, "Random number generator seed"},
+    };
+    static constexpr size_t N_PARAMETERS = sizeof(PARAMETERS) / sizeof(PARAMETERS[0]);
+    static constexpr const char * default_values[N_PARAMETERS]{0};
+
+private:
+    long get_cell(Eigen::Vector3d const & position) const;
+    std::vector<long> get_neighbor_cells(long cell) const;
+    Eigen::Vector3d get_minimum_image(Eigen::Vector3d const & r) const;
+    bool overlaps(Eigen::Vector3d const & position) const;
+    void move_cluster(size_t cluster);
+    void merge_clusters(size_t first, size_t second, Eigen::Vector3d const & shift);
+    void write_dump() const;
+
+    double r_part, box_size, step_size, mobility_exponent, cell_size;
+    long dump_period, n_cells;
+    size_t n_moves = 0, n_dumps = 0;
+    size_t smallest_cluster_size = 1;
+    std::vector<Eigen::Vector3d> x; // Primary positions, continuous across the periodic boundaries within a cluster
+    std::vector<size_t> cluster_of; // Cluster that each primary belongs to
+    std::vector<std::vector<size_t>> clusters; // Primaries of every cluster, empty once merged into another one
+    std::vector<size_t> active_clusters; // Clusters that have not been merged into another one
+    std::vector<std::vector<size_t>> cells; // Primaries in every cell of the grid over the wrapped positions
+};
+
+#endif //SOOT_DEM_GUI_DLCA_H
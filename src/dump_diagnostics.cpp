@@ -0,0 +1,53 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <cmath>
+
+#include "dump_diagnostics.h"
+#include "trace.h"
+
+DumpDiagnostics compute_dump_diagnostics(std::vector<Eigen::Vector3d> & x_prev,
+                                         std::vector<Eigen::Vector3d> const & x,
+                                         std::vector<Eigen::Vector3d> const & v,
+                                         std::vector<Eigen::Vector3d> const & a,
+                                         std::vector<Eigen::Vector3d> const & omega,
+                                         double mass, double inertia) {
+    TRACE_SCOPE("compute_dump_diagnostics");
+
+    const long n_part = long(x.size());
+
+    double sum_v_sq = 0.0,
+            sum_omega_sq = 0.0,
+            sum_displacement_sq = 0.0,
+            sum_a_sq = 0.0;
+
+#pragma omp parallel for default(none) shared(x_prev, x, v, a, omega, n_part) reduction(+:sum_v_sq, sum_omega_sq, sum_displacement_sq, sum_a_sq)
+    for (long i = 0; i < n_part; i ++) {
+        sum_v_sq += v[i].squaredNorm();
+        sum_omega_sq += omega[i].squaredNorm();
+        sum_displacement_sq += (x[i] - x_prev[i]).squaredNorm();
+        sum_a_sq += a[i].squaredNorm();
+
+        // Current positions become the reference for the next dump
+        x_prev[i] = x[i];
+    }
+
+    return {
+        0.5 * mass * sum_v_sq + 0.5 * inertia * sum_omega_sq,
+        sqrt(sum_displacement_sq / double(n_part)),
+        mass * sqrt(sum_a_sq / double(n_part))
+    };
+}
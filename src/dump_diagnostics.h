@@ -0,0 +1,40 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_DUMP_DIAGNOSTICS_H
+#define SOOT_DEM_GUI_DUMP_DIAGNOSTICS_H
+
+#include <vector>
+
+#include <Eigen/Eigen>
+
+struct DumpDiagnostics {
+    double ke;                  // Total kinetic energy (translational + rotational)
+    double rms_displacement;    // RMS displacement of particles since the previous dump
+    double rms_force;           // RMS force acting on particles
+};
+
+// Computes all quantities reported in a dump line in a single parallel pass over the particles.
+// x_prev must hold positions from the previous dump and is overwritten with the current positions,
+// so the same buffer can be reused for the next dump without reallocation
+DumpDiagnostics compute_dump_diagnostics(std::vector<Eigen::Vector3d> & x_prev,
+                                         std::vector<Eigen::Vector3d> const & x,
+                                         std::vector<Eigen::Vector3d> const & v,
+                                         std::vector<Eigen::Vector3d> const & a,
+                                         std::vector<Eigen::Vector3d> const & omega,
+                                         double mass, double inertia);
+
+#endif //SOOT_DEM_GUI_DUMP_DIAGNOSTICS_H
@@ -0,0 +1,29 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_ENABLED_SIMULATIONS_H
+#define SOOT_DEM_GUI_ENABLED_SIMULATIONS_H
+
+#include "restructuring_fixed_fraction.h"
+#include "restructuring_breaking.h"
+#include "aggregation.h"
+#include "aggregate_deposition.h"
+#include "anchored_restructuring_fixed_fraction.h"
+#include "dlca.h"
+
+#define ENABLED_SIMULATIONS RestructuringFixedFractionSimulation, RestructuringBreakingSimulation, AggregationSimulation, AggregateDepositionSimulation, AnchoredRestructuringFixedFractionSimulation, DlcaSimulation
+
+#endif //SOOT_DEM_GUI_ENABLED_SIMULATIONS_H
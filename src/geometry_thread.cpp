@@ -21,6 +21,7 @@
 #include "geometry_thread.h"
 
 #include "aggregate_stats.h"
+#include "trace.h"
 
 GeometryThread::GeometryThread(QObject * parent)
     : QThread(parent) {}
@@ -37,6 +38,9 @@ void GeometryThread::initialize(std::vector<Eigen::Vector3d> const & particle_po
 }
 
 void GeometryThread::run() {
+    TRACE_THREAD_NAME("geometry");
+    TRACE_SCOPE("GeometryThread::run");
+
     std::stringstream ss;
 
     std::vector<AggregateGraph> aggregates = find_aggregates(this->particle_positions, this->r_part, this->r_part / 10.0);
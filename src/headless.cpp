@@ -0,0 +1,86 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <memory>
+
+#include "enabled_simulations.h"
+#include "config.h"
+#include "headless.h"
+
+template<typename Head>
+std::shared_ptr<Simulation> make_simulation(std::string const & config_signature,
+                                            parameter_heap_t const & parameters,
+                                            std::filesystem::path const & working_directory) {
+    if (config_signature == Head::config_file_signature)
+        return std::make_shared<Head>(parameters, working_directory);
+    return nullptr;
+}
+
+template<typename Head, typename Mid, typename... Tail>
+std::shared_ptr<Simulation> make_simulation(std::string const & config_signature,
+                                            parameter_heap_t const & parameters,
+                                            std::filesystem::path const & working_directory) {
+    if (config_signature == Head::config_file_signature)
+        return std::make_shared<Head>(parameters, working_directory);
+    return make_simulation<Mid, Tail...>(config_signature, parameters, working_directory);
+}
+
+int run_headless(std::filesystem::path const & config_path, long max_dumps) {
+    std::shared_ptr<Simulation> simulation;
+
+    try {
+        auto [simulation_type, parameter_heap] = load_config_file(config_path);
+        simulation = make_simulation<ENABLED_SIMULATIONS>(simulation_type, parameter_heap,
+                                                          std::filesystem::absolute(config_path).parent_path());
+        if (!simulation) {
+            std::cerr << "Unknown simulation type `" << simulation_type << "`" << std::endl;
+            return EXIT_FAILURE;
+        }
+    } catch (UiException const & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Eigen::Vector3d> x0_buffer, neck_positions_buffer, neck_orientations_buffer;
+    std::vector<std::vector<Eigen::Vector3d>> polygon_buffer;
+
+    if (!simulation->initialize(std::cout, x0_buffer, neck_positions_buffer, neck_orientations_buffer, polygon_buffer)) {
+        std::cerr << "Unable to initialize the simulation" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << std::endl;
+
+    // Without a limit, a run that cannot finish on its own would never return
+    if (max_dumps <= 0 && !simulation->can_finish()) {
+        std::cerr << "This simulation does not stop on its own with the current parameters, specify the number of dumps" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    long n_dumps = 0;
+    while (!simulation->is_finished() && (max_dumps <= 0 || n_dumps < max_dumps)) {
+        auto message = std::get<0>(simulation->perform_iterations());
+        std::cout << message << std::endl;
+        n_dumps ++;
+    }
+
+    if (simulation->is_finished())
+        std::cout << simulation->get_finish_reason() << ", simulation stopped" << std::endl;
+    else
+        std::cout << "Dump limit reached, simulation stopped" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_HEADLESS_H
+#define SOOT_DEM_GUI_HEADLESS_H
+
+#include <filesystem>
+
+// Run the simulation described by a config file without the GUI, printing the dump log to stdout.
+// Runs until the simulation reports that it has finished or max_dumps dumps have been written (0 for no limit).
+// Simulations that never finish on their own are rejected unless a dump limit is given. Returns the process exit code
+int run_headless(std::filesystem::path const & config_path, long max_dumps);
+
+#endif //SOOT_DEM_GUI_HEADLESS_H
@@ -15,6 +15,11 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include "mainwindow.h"
+#include "headless.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
 #include <QApplication>
 #include <QSurfaceFormat>
@@ -24,6 +29,19 @@
 
 int main(int argc, char *argv[])
 {
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--headless") == 0) {
+        long max_dumps = 0;
+        if (argc == 4) {
+            char * end;
+            max_dumps = strtol(argv[3], &end, 10);
+            if (*end != '\0' || max_dumps <= 0) {
+                std::cerr << "The number of dumps must be a positive integer" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        return run_headless(argv[2], max_dumps);
+    }
+
     QSurfaceFormat::setDefaultFormat(QVTKOpenGLNativeWidget::defaultFormat());
     qRegisterMetaType<QVector<int> >("QVector<Eigen::Vector3d>");
     qRegisterMetaType<QVector<int> >("QVector<QVector<Eigen::Vector3d>>");
@@ -45,15 +45,10 @@
 #include "aboutdialog.h"
 #include "geometrydialog.h"
 
-#include "restructuring_fixed_fraction.h"
-#include "restructuring_breaking.h"
-#include "aggregation.h"
-#include "aggregate_deposition.h"
-#include "anchored_restructuring_fixed_fraction.h"
+#include "enabled_simulations.h"
 
 #include "config.h"
-
-#define ENABLED_SIMULATIONS RestructuringFixedFractionSimulation, RestructuringBreakingSimulation, AggregationSimulation, AggregateDepositionSimulation, AnchoredRestructuringFixedFractionSimulation
+#include "trace.h"
 
 template<typename T1, typename T2>
 inline void set_enabled(T1 * obj1, T2 * obj2, bool state) {
@@ -171,12 +166,15 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
+    TRACE_THREAD_NAME("gui");
+
     update_tool_buttons();
 
     /* Set up compute thread signal handlers */
 
     connect(&compute_thread, &ComputeThread::step_done, this, &MainWindow::compute_step_done);
     connect(&compute_thread, &ComputeThread::pause_done, this, &MainWindow::pause_done);
+    connect(&compute_thread, &ComputeThread::simulation_finished, this, &MainWindow::simulation_finished);
 
     /* Set up button actions */
 
@@ -213,6 +211,11 @@ MainWindow::MainWindow(QWidget *parent)
     // About simulation button
     connect(ui->aboutSimulationButton, &QAbstractButton::clicked, this, &MainWindow::about_simulation_handler);
     connect(ui->actionInfoAbout_simulation_type, &QAction::triggered, this, &MainWindow::about_simulation_handler);
+    // Export trace button
+    connect(ui->actionExportTrace, &QAction::triggered, this, &MainWindow::export_trace_handler);
+#ifndef USE_TRACING
+    ui->actionExportTrace->setVisible(false);
+#endif //USE_TRACING
 
     connect(ui->simulationTypeSelector, SIGNAL(currentIndexChanged(int)), this, SLOT(simulation_type_combo_handler()));
     connect(ui->parameterTable, &QTableWidget::itemChanged, this, &MainWindow::parameters_changed);
@@ -303,6 +306,7 @@ template<typename SimulationType>
 bool MainWindow::initialize_parameter_table_with_data(parameter_heap_t const & parameters) {
 
     watching_parameter_table = false;
+    bool missing_parameters = false;
 
     parameter_table_fields.resize(SimulationType::N_PARAMETERS * 4);
 
@@ -317,28 +321,35 @@ bool MainWindow::initialize_parameter_table_with_data(parameter_heap_t const & p
         parameter_table_fields[i*4+1].setFlags(Qt::NoItemFlags | Qt::ItemIsEnabled);
 
         std::stringstream ss;
-        auto [type_heap, value_heap] = parameters.at(id);
-        if (type_heap != type) {
-            throw UiException("Parameter type mismatch");
-        }
-
-        switch (type) {
-            case REAL: {
-                ss << value_heap.real_value;
-                parameter_table_fields[i*4+2].setText(QString::fromStdString(ss.str()));
-                break;
-            }
-            case INTEGER: {
-                ss << value_heap.integer_value;
-                parameter_table_fields[i*4+2].setText(QString::fromStdString(ss.str()));
-                break;
+        auto parameter_itr = parameters.find(id);
+        if (parameter_itr == parameters.end()) {
+            // Parameter was introduced after the config file had been written, leave it for the user to fill in
+            parameter_table_fields[i*4+2].setText("");
+            missing_parameters = true;
+        } else {
+            auto [type_heap, value_heap] = parameter_itr->second;
+            if (type_heap != type) {
+                throw UiException("Parameter type mismatch");
             }
-            case STRING: {
-                parameter_table_fields[i*4+2].setText(QString::fromStdString(value_heap.string_value));
-                break;
-            }
-            case PATH: {
-                parameter_table_fields[i*4+2].setText(QString::fromStdString(value_heap.path_value.string()));
+
+            switch (type) {
+                case REAL: {
+                    ss << value_heap.real_value;
+                    parameter_table_fields[i*4+2].setText(QString::fromStdString(ss.str()));
+                    break;
+                }
+                case INTEGER: {
+                    ss << value_heap.integer_value;
+                    parameter_table_fields[i*4+2].setText(QString::fromStdString(ss.str()));
+                    break;
+                }
+                case STRING: {
+                    parameter_table_fields[i*4+2].setText(QString::fromStdString(value_heap.string_value));
+                    break;
+                }
+                case PATH: {
+                    parameter_table_fields[i*4+2].setText(QString::fromStdString(value_heap.path_value.string()));
+                }
             }
         }
 
@@ -356,7 +367,7 @@ bool MainWindow::initialize_parameter_table_with_data(parameter_heap_t const & p
     ui->parameterTable->resizeColumnToContents(3);
 
     watching_parameter_table = true;
-    configuration_state = SAVED;
+    configuration_state = missing_parameters ? PATH_CHOSEN : SAVED;
     update_configuration_state();
 
     return true;
@@ -628,6 +639,27 @@ void MainWindow::geometry_dialog_handler() {
     geometryDialog.exec();
 }
 
+void MainWindow::export_trace_handler() {
+    QString trace_file_path = QFileDialog::getSaveFileName(
+            this,
+            "Export performance trace",
+            configurations_file_path.isEmpty()
+                ? QDir::homePath()
+                : QString::fromStdString(std::filesystem::path(configurations_file_path.toStdString()).parent_path().string()),
+            "JSON Files (*.json)"
+    );
+
+    // Check if user canceled
+    if (trace_file_path.isEmpty())
+        return;
+
+    try {
+        write_chrome_trace(trace_file_path.toStdString());
+    } catch (UiException const & e) {
+        QMessageBox::warning(this, "Trace export error", "Unable to write trace file to `" + trace_file_path + "`");
+    }
+}
+
 bool MainWindow::save_as_button_handler() {
     bool result = save_as();
     if (result)
@@ -867,6 +899,7 @@ void MainWindow::compute_step_done(QString const & message,
                                    QVector<Eigen::Vector3d> const & neck_positions,
                                    QVector<Eigen::Vector3d> const & neck_orientations,
                                    QVector<QVector<Eigen::Vector3d>> const & polygons) {
+    TRACE_SCOPE("MainWindow::compute_step_done");
 
     ui->stdoutBox->appendPlainText(message);
 
@@ -893,11 +926,18 @@ void MainWindow::pause_done() {
     update_tool_buttons();
 }
 
+void MainWindow::simulation_finished(QString const & reason) {
+    ui->stdoutBox->appendPlainText(reason + ", simulation stopped");
+    simulation_state = PAUSE;
+    update_tool_buttons();
+}
+
 void MainWindow::initialize_preview(
         std::vector<Eigen::Vector3d> const & x,
         std::vector<Eigen::Vector3d> const & neck_positions,
         std::vector<Eigen::Vector3d> const & neck_orientations,
         std::vector<std::vector<Eigen::Vector3d>> const & polygons) {
+    TRACE_SCOPE("MainWindow::initialize_preview");
 
     // Initialize particle representations
     vtk_particles_representation.reserve(x.size());
@@ -981,6 +1021,7 @@ void MainWindow::update_preview(std::vector<Eigen::Vector3d> const & x,
                                 std::vector<Eigen::Vector3d> const & neck_positions,
                                 std::vector<Eigen::Vector3d> const & neck_orientations,
                                 std::vector<std::vector<Eigen::Vector3d>> const & polygons) {
+    TRACE_SCOPE("MainWindow::update_preview");
 
     // Delete necks that have been broken
 
@@ -1002,7 +1043,10 @@ void MainWindow::update_preview(std::vector<Eigen::Vector3d> const & x,
         vtk_necks_representation[i].second->RotateWXYZ(angle_deg, axis[0], axis[1], axis[2]);
         vtk_necks_representation[i].second->SetPosition(neck_positions[i][0] / r_part, neck_positions[i][1] / r_part, neck_positions[i][2] / r_part);
     }
-    vtk_render_window->Render();
+    {
+        TRACE_SCOPE("vtk render");
+        vtk_render_window->Render();
+    }
 }
 
 void MainWindow::reset_preview() {
@@ -78,7 +78,9 @@ private slots:
     void about_simulation_handler();
     void about_dialog_handler();
     void geometry_dialog_handler();
+    void export_trace_handler();
     void pause_done();
+    void simulation_finished(QString const & reason);
     void reset_button_handler();
     void play_button_handler();
     void play_all_button_handler();
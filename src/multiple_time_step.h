@@ -0,0 +1,58 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_MULTIPLE_TIME_STEP_H
+#define SOOT_DEM_GUI_MULTIPLE_TIME_STEP_H
+
+#include <vector>
+#include <utility>
+
+// Wraps a slowly varying binary force functor for impulse (r-RESPA) multiple time stepping.
+// The wrapped force is only evaluated for the positions of every period-th step and is scaled by period there.
+// With a velocity Verlet integrator, the two half kicks around such a step then deliver the outer
+// r-RESPA impulse, while the remaining (stiff) forces are integrated with the inner time step
+template<typename field_type, typename real_type, typename functor_t>
+class multiple_time_step_functor {
+public:
+    multiple_time_step_functor(functor_t & slow_functor, long period)
+        : slow_functor{slow_functor}
+        , period{period} {}
+
+    // Must be called with the number of the step whose final positions the next force evaluation is for
+    void set_step(size_t step) {
+        active = step % period == 0;
+    }
+
+    std::pair<field_type, field_type> operator () (size_t i, size_t j,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        if (!active)
+            return {field_type::Zero(), field_type::Zero()};
+
+        auto [a, alpha] = slow_functor(i, j, x, v, theta, omega, t);
+        return {real_type(period) * a, real_type(period) * alpha};
+    }
+
+private:
+    functor_t & slow_functor;
+    const long period;
+    bool active = true; // The initial force evaluation is at step 0
+};
+
+#endif //SOOT_DEM_GUI_MULTIPLE_TIME_STEP_H
@@ -0,0 +1,55 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <numeric>
+
+#include "neck_information.h"
+
+std::tuple<std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>>
+compute_neck_information(std::vector<bool> const & bonded_contacts, std::vector<Eigen::Vector3d> const & x) {
+    const long n_part = long(x.size());
+
+    // First pass: count the necks in every row, so that each row can be filled independently in the second pass
+    std::vector<size_t> row_offsets(n_part + 1, 0);
+
+    #pragma omp parallel for default(none) shared(bonded_contacts, row_offsets, n_part) schedule(dynamic, 64)
+    for (long i = 0; i < n_part; i ++) {
+        size_t count = 0;
+        for (long j = i + 1; j < n_part; j ++) {
+            count += bonded_contacts[i * n_part + j];
+        }
+        row_offsets[i + 1] = count;
+    }
+
+    std::partial_sum(row_offsets.begin(), row_offsets.end(), row_offsets.begin());
+
+    std::vector<Eigen::Vector3d> neck_positions(row_offsets.back()), neck_orientations(row_offsets.back());
+
+    #pragma omp parallel for default(none) shared(bonded_contacts, x, row_offsets, neck_positions, neck_orientations, n_part) schedule(dynamic, 64)
+    for (long i = 0; i < n_part; i ++) {
+        size_t k = row_offsets[i];
+        for (long j = i + 1; j < n_part; j ++) {
+            if (!bonded_contacts[i * n_part + j])
+                continue;
+
+            neck_positions[k] = (x[j] + x[i]) / 2.0;
+            neck_orientations[k] = (x[j] - x[i]).normalized();
+            k ++;
+        }
+    }
+
+    return {neck_positions, neck_orientations};
+}
@@ -0,0 +1,30 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_NECK_INFORMATION_H
+#define SOOT_DEM_GUI_NECK_INFORMATION_H
+
+#include <tuple>
+#include <vector>
+
+#include <Eigen/Eigen>
+
+// Positions (midpoints) and unit orientations of all necks in the N x N bonded contact matrix.
+// Necks are listed in row-major order of the upper triangle (pairs i < j)
+std::tuple<std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>>
+compute_neck_information(std::vector<bool> const & bonded_contacts, std::vector<Eigen::Vector3d> const & x);
+
+#endif //SOOT_DEM_GUI_NECK_INFORMATION_H
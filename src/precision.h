@@ -0,0 +1,75 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_PRECISION_H
+#define SOOT_DEM_GUI_PRECISION_H
+
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include <Eigen/Eigen>
+
+// Evaluates a binary force functor instantiated with a narrower field type (force_field_type) on the state of a
+// granular system that is integrated in field_type. Positions are passed to the functor relative to particle i,
+// so the separation is formed before it is narrowed and does not lose the precision of the absolute positions.
+// The returned accelerations are widened before the granular system accumulates them.
+// The wrapped functor must only read the entries of particles i and j, its per-pair state stays indexed by i and j.
+// If both field types are the same, the call is forwarded unchanged
+template<typename field_type, typename real_type, typename force_field_type, typename force_real_type, typename functor_t>
+class mixed_precision_force_functor {
+public:
+    explicit mixed_precision_force_functor(functor_t & functor)
+        : functor{functor} {}
+
+    std::pair<field_type, field_type> operator () (size_t i, size_t j,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        if constexpr (std::is_same_v<field_type, force_field_type>) {
+            return functor(i, j, x, v, theta, omega, t);
+        } else {
+            // Pairs are evaluated concurrently, so every thread narrows the state into its own buffers.
+            // Only the entries of particles i and j are written
+            thread_local std::vector<force_field_type> x_narrow, v_narrow, theta_narrow, omega_narrow;
+            if (x_narrow.size() < x.size()) {
+                x_narrow.resize(x.size());
+                v_narrow.resize(x.size());
+                theta_narrow.resize(x.size());
+                omega_narrow.resize(x.size());
+            }
+
+            x_narrow[i] = force_field_type::Zero();
+            x_narrow[j] = (x[j] - x[i]).template cast<force_real_type>();
+            v_narrow[i] = v[i].template cast<force_real_type>();
+            v_narrow[j] = v[j].template cast<force_real_type>();
+            theta_narrow[i] = theta[i].template cast<force_real_type>();
+            theta_narrow[j] = theta[j].template cast<force_real_type>();
+            omega_narrow[i] = omega[i].template cast<force_real_type>();
+            omega_narrow[j] = omega[j].template cast<force_real_type>();
+
+            auto [a, alpha] = functor(i, j, x_narrow, v_narrow, theta_narrow, omega_narrow, force_real_type(t));
+            return {a.template cast<real_type>(), alpha.template cast<real_type>()};
+        }
+    }
+
+private:
+    functor_t & functor;
+};
+
+#endif //SOOT_DEM_GUI_PRECISION_H
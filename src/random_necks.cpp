@@ -0,0 +1,44 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+#include <random_engine.h>
+
+#include "random_necks.h"
+
+void break_random_necks(std::vector<bool> & bonded_contacts, size_t n_part, size_t n_breaks) {
+    std::vector<std::pair<size_t, size_t>> necks;
+    for (size_t i = 0; i < n_part; i ++) {
+        for (size_t j = i + 1; j < n_part; j ++) {
+            if (bonded_contacts[i * n_part + j])
+                necks.emplace_back(i, j);
+        }
+    }
+
+    n_breaks = std::min(n_breaks, necks.size());
+
+    for (size_t k = 0; k < n_breaks; k ++) {
+        std::uniform_int_distribution<size_t> dist(k, necks.size() - 1);
+        std::swap(necks[k], necks[dist(get_random_engine())]);
+
+        auto [i, j] = necks[k];
+        bonded_contacts[i * n_part + j] = false;
+        bonded_contacts[j * n_part + i] = false;
+    }
+}
@@ -0,0 +1,28 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_RANDOM_NECKS_H
+#define SOOT_DEM_GUI_RANDOM_NECKS_H
+
+#include <cstddef>
+#include <vector>
+
+// Break n_breaks necks chosen uniformly at random without replacement from the N x N bonded contact matrix.
+// The necks are collected into an edge list once and drawn with a partial Fisher-Yates shuffle
+// using the global random engine, so the selection is reproducible for a given seed
+void break_random_necks(std::vector<bool> & bonded_contacts, size_t n_part, size_t n_breaks);
+
+#endif //SOOT_DEM_GUI_RANDOM_NECKS_H
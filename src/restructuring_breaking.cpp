@@ -18,6 +18,7 @@
 #include "format_wrapper.h"
 #include <random>
 
+#include "trace.h"
 #include "restructuring_breaking.h"
 
 RestructuringBreakingSimulation::RestructuringBreakingSimulation(
@@ -30,6 +31,8 @@ RestructuringBreakingSimulation::initialize(std::ostream &output_stream, std::ve
                                                  std::vector<Eigen::Vector3d> &neck_positions_buffer,
                                                  std::vector<Eigen::Vector3d> &neck_orientations_buffer,
                                                  std::vector<std::vector<Eigen::Vector3d>> & polygons) {
+    TRACE_SCOPE("Simulation::initialize");
+
     // General parameters
     auto rho = get_real_parameter("rho");
     auto r_verlet = get_real_parameter("r_verlet");
@@ -65,9 +68,18 @@ RestructuringBreakingSimulation::initialize(std::ostream &output_stream, std::ve
     auto f_coat_mag = get_real_parameter("f_coat_max");
     auto f_coat_cutoff = get_real_parameter("f_coat_cutoff");
     auto f_coat_drop_rate = get_real_parameter("f_coat_drop_rate");
+    auto coating_substeps = get_integer_parameter("coating_substeps");
+    auto force_table_size = get_integer_parameter("force_table_size");
+    auto force_table_tolerance = get_real_parameter("force_table_tolerance");
 
     auto aggregate_type = get_string_parameter("aggregate_type");
     auto aggregate_path = get_path_parameter("aggregate_path");
+    AggregateGeneratorParameters generator_parameters {
+            get_integer_parameter("aggregate_n_part"),
+            get_real_parameter("aggregate_df"),
+            get_real_parameter("aggregate_kf"),
+            get_integer_parameter("aggregate_seed")
+    };
 
     auto rng_seed = get_integer_parameter("rng_seed");
 
@@ -82,21 +94,37 @@ RestructuringBreakingSimulation::initialize(std::ostream &output_stream, std::ve
     dt = get_real_parameter("dt");
     dump_period = get_integer_parameter("dump_period");
     neighbor_update_period = get_integer_parameter("neighbor_update_period");
+    checkpoint_period = get_integer_parameter("checkpoint_period");
+    resume_checkpoint = get_integer_parameter("resume_checkpoint") != 0;
+    converged_ke = get_real_parameter("converged_ke");
+    converged_rms_displacement = get_real_parameter("converged_rms_displacement");
+    converged_dumps = get_integer_parameter("converged_dumps");
     r_part = get_real_parameter("r_part");
     mass = 4.0 / 3.0 * M_PI * pow(r_part, 3.0) * rho;
     inertia = 2.0 / 5.0 * mass * pow(r_part, 2.0);
 
+    auto dt_safety_factor = get_real_parameter("dt_safety_factor");
+    if (dt_safety_factor > 0.0) {
+        auto dt_stable = get_stable_time_step(mass, inertia, r_part, {{k_n, k_t, k_r, k_o}, {k_n_bond, k_t_bond, k_r_bond, k_o_bond}}, {},
+                                              dt_safety_factor);
+        if (dt_stable < dt) {
+            dt = dt_stable;
+            output_stream << "Time step reduced to " << dt << " to resolve the stiffest spring" << std::endl;
+        }
+    }
+
+    if (coating_substeps < 1) {
+        std::cerr << "coating_substeps must be at least 1" << std::endl;
+        return false;
+    }
+
     // Declare the initial condition buffers
     std::vector<Eigen::Vector3d> x0, v0, theta0, omega0;
 
-    if (aggregate_type == "vtk") {
-        x0 = load_vtk_aggregate(simulation_working_directory / aggregate_path, r_part);
-    } else if (aggregate_type == "mackowski") {
-        x0 = load_mackowski_aggregate(simulation_working_directory / aggregate_path, r_part);
-    } else if (aggregate_type == "flage") {
-        x0 = load_flage_aggregate(simulation_working_directory / aggregate_path, r_part);
-    } else {
-        std::cerr << "Unrecognized aggregate type: " << aggregate_type << std::endl;
+    try {
+        x0 = load_aggregate(aggregate_type, simulation_working_directory / aggregate_path, r_part, generator_parameters);
+    } catch (UiException const & e) {
+        std::cerr << e.what() << std::endl;
         return false;
     }
 
@@ -106,6 +134,12 @@ RestructuringBreakingSimulation::initialize(std::ostream &output_stream, std::ve
     }
     output_stream << "Loaded an aggregate of size " << x0.size() << std::endl;
 
+    if (get_integer_parameter("reorder_particles") != 0) {
+        particle_order = morton_order(x0, 2.0 * r_part);
+        x0 = apply_order(x0, particle_order);
+        output_stream << "Reordered particles along a Morton curve" << std::endl;
+    }
+
     x0_buffer = x0;
 
     // Fill the remaining buffers with zeros
@@ -129,10 +163,22 @@ RestructuringBreakingSimulation::initialize(std::ostream &output_stream, std::ve
             r_part, mass, inertia, dt, Eigen::Vector3d::Zero(), 0.0);
 
     coating_model = std::make_unique<coating_model_t>(f_coat_cutoff, f_coat_mag, f_coat_drop_rate, mass, Eigen::Vector3d::Zero());
+    // The capillary force jumps at f_coat_cutoff, which therefore becomes a knot of the table
+    coating_table_model = std::make_unique<coating_table_model_t>(*coating_model, r_part, r_verlet, std::max(force_table_size, 0l), f_coat_cutoff);
+    coating_mts_model = std::make_unique<coating_mts_model_t>(*coating_table_model, coating_substeps);
+
+    if (coating_table_model->is_tabulated()) {
+        auto table_error = coating_table_model->get_max_relative_error();
+        output_stream << "Tabulated capillary force with relative error " << table_error << std::endl;
+        if (table_error > force_table_tolerance) {
+            std::cerr << "Capillary force table error exceeds force_table_tolerance, increase force_table_size" << std::endl;
+            return false;
+        }
+    }
 
     unary_force_container = std::make_unique<unary_force_container_t>();
 
-    binary_force_container = std::make_unique<binary_force_container_t>(*aggregate_model, *coating_model);
+    binary_force_container = std::make_unique<binary_force_container_t>(*aggregate_model, *coating_mts_model);
 
     granular_system = std::make_unique<granular_system_t>(x0.size(), r_verlet, x0,
                                                           v0, theta0, omega0, 0.0, Eigen::Vector3d::Zero(), 0.0,
@@ -157,109 +203,192 @@ RestructuringBreakingSimulation::initialize(std::ostream &output_stream, std::ve
     neck_positions_buffer = neck_positions;
     neck_orientations_buffer = neck_orientations;
 
+    if (restore_checkpoint(output_stream, r_verlet)) {
+        x0_buffer = granular_system->get_x();
+        auto [restored_neck_positions, restored_neck_orientations] = get_neck_information();
+        neck_positions_buffer = restored_neck_positions;
+        neck_orientations_buffer = restored_neck_orientations;
+    }
+    n_necks_prev = neck_positions_buffer.size();
+
+    x_prev = granular_system->get_x();
+
     output_stream << "Dump\tTime\tKE\tRMS_disp\tRMS_force\tfrac_necks";
 
-    dump_particles(dump_directory.string(), current_step / dump_period, granular_system->get_x(),
-                   granular_system->get_v(), granular_system->get_a(),
-                   granular_system->get_omega(), granular_system->get_alpha(), r_part);
-    dump_necks(dump_directory.string(), current_step / dump_period, granular_system->get_x(), aggregate_model->get_bonded_contacts(), r_part);
+    write_dump();
 
     return true;
 }
 
 std::tuple<std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>> RestructuringBreakingSimulation::get_neck_information() const {
-    auto const & bonded_contacts = aggregate_model->get_bonded_contacts();
-    auto const & x = granular_system->get_x();
-    size_t neck_count = std::count(bonded_contacts.begin(), bonded_contacts.end(), true) / 2u;
-
-    std::vector<Eigen::Vector3d> neck_positions, neck_orientations;
-
-    neck_positions.reserve(neck_count);
-    neck_orientations.reserve(neck_count);
-
-    for (size_t i = 0; i < x.size() - 1; i ++) {
-        for (size_t j = i + 1; j < x.size(); j ++) {
-            if (!bonded_contacts[i * x.size() + j])
-                continue;
-
-            // This is a bonded contact
-            Eigen::Vector3d position = (x[j] + x[i]) / 2.0; // Compute the position
-
-            neck_positions.emplace_back(position[0], position[1], position[2]);
-        }
-    }
-
-    for (size_t i = 0; i < x.size() - 1; i ++) {
-        for (size_t j = i + 1; j < x.size(); j ++) {
-            if (!bonded_contacts[i * x.size() + j])
-                continue;
-
-            // This is a bonded contact
-            Eigen::Vector3d orientation = (x[j] - x[i]).normalized(); // Compute the orientation vector
-
-            neck_orientations.emplace_back(orientation[0], orientation[1], orientation[2]);
-        }
-    }
-
-    return std::make_tuple(neck_positions, neck_orientations);
+    return compute_neck_information(aggregate_model->get_bonded_contacts(), granular_system->get_x());
 }
 
 std::tuple<std::string, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<Eigen::Vector3d>, std::vector<std::vector<Eigen::Vector3d>>> RestructuringBreakingSimulation::perform_iterations() {
-
-    std::vector<Eigen::Vector3d> x_before_iter = granular_system->get_x();
+    TRACE_SCOPE("Simulation::perform_iterations");
 
     for (int i = 0; i < dump_period; i ++) {
         if (current_step % neighbor_update_period == 0) {
+            TRACE_SCOPE("update_neighbor_list");
             granular_system->update_neighbor_list();
         }
-        granular_system->do_step(dt);
-
-        break_strained_necks(
-                *aggregate_model,
-                granular_system->get_x(),
-                k_n_bond,
-                k_t_bond,
-                k_r_bond,
-                k_o_bond,
-                neck_strengths,
-                r_part
-        );
-
-        current_step ++;
-    }
-
-    double rms_displacement = 0.0,
-            rms_force = 0.0;
+        {
+            TRACE_SCOPE("do_step");
+            coating_mts_model->set_step(current_step + 1);
+            granular_system->do_step(dt);
+        }
 
-    for (int i = 0; i < x_before_iter.size(); i ++) {
-        Eigen::Vector3d displacement = x_before_iter[i] - granular_system->get_x()[i];
-        rms_displacement += displacement.dot(displacement);
+        {
+            TRACE_SCOPE("break_strained_necks");
+            break_strained_necks(
+                    *aggregate_model,
+                    granular_system->get_x(),
+                    k_n_bond,
+                    k_t_bond,
+                    k_r_bond,
+                    k_o_bond,
+                    neck_strengths,
+                    r_part
+            );
+        }
 
-        Eigen::Vector3d force = granular_system->get_a()[i] * mass;
-        rms_force += force.dot(force);
+        current_step ++;
     }
 
-    rms_displacement = sqrt(rms_displacement / double(x_before_iter.size()));
-    rms_force = sqrt(rms_force / double(x_before_iter.size()));
+    auto [ke, rms_displacement, rms_force] = compute_dump_diagnostics(x_prev, granular_system->get_x(),
+                                                                      granular_system->get_v(), granular_system->get_a(),
+                                                                      granular_system->get_omega(), mass, inertia);
 
     auto [neck_positions, neck_orientations] = get_neck_information();
 
+    // A dump only counts as converged if no necks were broken since the previous one
+    if (ke < converged_ke && rms_displacement < converged_rms_displacement && neck_positions.size() == n_necks_prev)
+        n_converged_dumps ++;
+    else
+        n_converged_dumps = 0;
+    n_necks_prev = neck_positions.size();
+
     std::stringstream message_out;
     auto fmt = format_string(
             "{}\t{:.1e}\t{:.2e}\t{:.2e}\t{:.2e}\t{:.2f}",   // format string
             current_step / dump_period,  // dump number
             double(current_step) * dt,  // time
-            compute_ke(granular_system->get_v(), granular_system->get_omega(), mass, inertia),  // total kinetic energy
+            ke,  // total kinetic energy
             rms_displacement,   // rms displacement of particles from the last dump
             rms_force,   // rms force acting on particles
             double(neck_positions.size()) / double(n_necks_init)    // necking fraction
     );
     message_out << fmt;
 
-    dump_particles(dump_directory.string(), current_step / dump_period, granular_system->get_x(),
-                   granular_system->get_v(), granular_system->get_a(),
-                   granular_system->get_omega(), granular_system->get_alpha(), r_part);
-    dump_necks(dump_directory.string(), current_step / dump_period, granular_system->get_x(), aggregate_model->get_bonded_contacts(), r_part);
+    write_dump();
+
+    if (checkpoint_period > 0 && (current_step / dump_period) % checkpoint_period == 0) {
+        try {
+            write_checkpoint();
+        } catch (UiException const & e) {
+            message_out << "\n" << e.what();
+        }
+    }
 
     return {message_out.str(), granular_system->get_x(), neck_positions, neck_orientations, {}};
 }
+
+bool RestructuringBreakingSimulation::is_finished() const {
+    return converged_dumps > 0 && n_converged_dumps >= converged_dumps;
+}
+
+bool RestructuringBreakingSimulation::can_finish() const {
+    return converged_dumps > 0;
+}
+
+std::string RestructuringBreakingSimulation::get_finish_reason() const {
+    return "Convergence criteria met";
+}
+
+// Dumps are always written in the original particle order
+void RestructuringBreakingSimulation::write_dump() const {
+    TRACE_SCOPE("dump");
+
+    // Without reordering the live containers are passed through and the buffers stay empty
+    std::vector<Eigen::Vector3d> x_buffer, v_buffer, a_buffer, omega_buffer, alpha_buffer;
+    std::vector<bool> bonded_contacts_buffer;
+    auto const & x = restore_order(granular_system->get_x(), particle_order, x_buffer);
+    dump_particles(dump_directory.string(), current_step / dump_period, x,
+                   restore_order(granular_system->get_v(), particle_order, v_buffer),
+                   restore_order(granular_system->get_a(), particle_order, a_buffer),
+                   restore_order(granular_system->get_omega(), particle_order, omega_buffer),
+                   restore_order(granular_system->get_alpha(), particle_order, alpha_buffer), r_part);
+    dump_necks(dump_directory.string(), current_step / dump_period, x,
+               restore_pair_order(aggregate_model->get_bonded_contacts(), particle_order, bonded_contacts_buffer), r_part);
+}
+
+void RestructuringBreakingSimulation::write_checkpoint() const {
+    TRACE_SCOPE("write_checkpoint");
+
+    CheckpointWriter writer(get_checkpoint_path(), config_file_signature, get_parameter_fingerprint());
+    writer.write(current_step);
+    writer.write(granular_system->get_x());
+    writer.write(granular_system->get_v());
+    writer.write(granular_system->get_theta());
+    writer.write(granular_system->get_omega());
+    writer.write(aggregate_model->get_bonded_contacts());
+    writer.write(neck_strengths);
+
+    std::stringstream rng_state;
+    rng_state << get_random_engine();
+    writer.write(rng_state.str());
+    writer.commit();
+}
+
+// Replaces the freshly initialized state with the state stored in the checkpoint, if one exists and resuming was requested
+bool RestructuringBreakingSimulation::restore_checkpoint(std::ostream & output_stream, double r_verlet) {
+    if (!resume_checkpoint || !std::filesystem::exists(get_checkpoint_path()))
+        return false;
+
+    size_t step;
+    std::vector<Eigen::Vector3d> x, v, theta, omega;
+    std::vector<bool> bonded_contacts;
+    std::vector<double> strengths;
+    std::string rng_state;
+
+    try {
+        CheckpointReader reader(get_checkpoint_path(), config_file_signature);
+        if (reader.get_parameter_fingerprint() != get_parameter_fingerprint()) {
+            output_stream << "Checkpoint was written with different parameters, starting a new run" << std::endl;
+            return false;
+        }
+
+        reader.read(step);
+        reader.read(x);
+        reader.read(v);
+        reader.read(theta);
+        reader.read(omega);
+        reader.read(bonded_contacts);
+        reader.read(strengths);
+        reader.read(rng_state);
+
+        if (x.size() != granular_system->get_x().size()
+                || bonded_contacts.size() != aggregate_model->get_bonded_contacts().size()
+                || strengths.size() != neck_strengths.size())
+            throw UiException("Checkpoint does not match the initialized system");
+    } catch (UiException const & e) {
+        output_stream << "Unable to resume from checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+
+    current_step = step;
+    aggregate_model->get_bonded_contacts() = bonded_contacts;
+    neck_strengths = strengths;
+    std::stringstream(rng_state) >> get_random_engine();
+    coating_mts_model->set_step(current_step);
+    granular_system = std::make_unique<granular_system_t>(x.size(), r_verlet, x,
+                                                          v, theta, omega, double(current_step) * dt, Eigen::Vector3d::Zero(), 0.0,
+                                                          step_handler_instance, *binary_force_container, *unary_force_container);
+
+    output_stream << "Resumed from checkpoint at step " << current_step << std::endl;
+    // soot-dem and libgran do not expose the spring history of their force models
+    output_stream << "Warning: checkpoints do not store contact, neck spring history, all tangential, rolling and torsional "
+                     "springs were reset to zero extension and the resumed run will not reproduce an uninterrupted one" << std::endl;
+
+    return true;
+}
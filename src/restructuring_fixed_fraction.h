@@ -41,12 +41,22 @@
 #include <break_neck.h>
 
 #include "simulation.h"
+#include "dump_diagnostics.h"
+#include "checkpoint.h"
+#include "aggregate_loader.h"
+#include "neck_information.h"
+#include "multiple_time_step.h"
+#include "tabulated_force.h"
+#include "spatial_ordering.h"
+#include "random_necks.h"
 
 class RestructuringFixedFractionSimulation : public Simulation {
 public:
     using aggregate_model_t = aggregate<Eigen::Vector3d, double>;
     using coating_model_t = binary_coating_functor<Eigen::Vector3d, double>;
-    using binary_force_container_t = binary_force_functor_container<Eigen::Vector3d, double, aggregate_model_t, coating_model_t>;
+    using coating_table_model_t = tabulated_force_functor<Eigen::Vector3d, double, coating_model_t>;
+    using coating_mts_model_t = multiple_time_step_functor<Eigen::Vector3d, double, coating_table_model_t>;
+    using binary_force_container_t = binary_force_functor_container<Eigen::Vector3d, double, aggregate_model_t, coating_mts_model_t>;
     using unary_force_container_t = unary_force_functor_container<Eigen::Vector3d, double>;
     using granular_system_t = granular_system_neighbor_list<Eigen::Vector3d, double, rotational_velocity_verlet_half,
             rotational_step_handler, binary_force_container_t, unary_force_container_t>;
@@ -69,6 +79,10 @@ public:
         std::vector<Eigen::Vector3d>,
         std::vector<std::vector<Eigen::Vector3d>>> perform_iterations() override;
 
+    bool is_finished() const override;
+    bool can_finish() const override;
+    std::string get_finish_reason() const override;
+
     static constexpr const char * config_file_signature = "gui_restructuring";
     static constexpr const char * combo_label = "Restructuring - fixed neck fraction";
     static constexpr unsigned int combo_id = 0;
@@ -127,11 +141,17 @@ public:
 
     static constexpr std::tuple<const char *, ParameterType, const char *> PARAMETERS[] {
             {"A", REAL, "Hamaker constant"},
+            {"aggregate_df", REAL, "Fractal dimension of a generated aggregate"},
+            {"aggregate_kf", REAL, "Fractal prefactor of a generated aggregate"},
+            {"converged_ke", REAL, "Kinetic energy below which a dump counts as converged"},
+            {"converged_rms_displacement", REAL, "RMS displacement below which a dump counts as converged"},
             {"d_crit", REAL, "Critical separation for a contact"},
             {"dt", REAL, "Integration time step"},
+            {"dt_safety_factor", REAL, "Upper bound for dt as a fraction of the critical time step (0 to disable)"},
             {"f_coat_cutoff", REAL, "Capillary force cutoff distance"},
             {"f_coat_drop_rate", REAL, "Capillary force drop rate"},
             {"f_coat_max", REAL, "Capillary force maximum magnitude"},
+            {"force_table_tolerance", REAL, "Largest allowed relative error of the tabulated capillary force"},
             {"frac_necks", REAL, "Necking fraction"},
             {"gamma_n", REAL, "Normal damping coefficient"},
             {"gamma_n_bond", REAL, "Normal bond damping coefficient"},
@@ -159,10 +179,18 @@ public:
             {"r_part", REAL, "Primary particle radius"},
             {"r_verlet", REAL, "Verlet radius"},
             {"rho", REAL, "Density"},
+            {"aggregate_n_part", INTEGER, "Number of primaries in a generated aggregate"},
+            {"aggregate_seed", INTEGER, "Random number generator seed for a generated aggregate"},
+            {"checkpoint_period", INTEGER, "Checkpoint period in dumps (0 to disable)"},
+            {"coating_substeps", INTEGER, "Capillary force evaluation period in steps (1 to evaluate every step)"},
+            {"converged_dumps", INTEGER, "Consecutive converged dumps after which the run stops (0 to disable)"},
             {"dump_period", INTEGER, "Dump period"},
+            {"force_table_size", INTEGER, "Number of points in the capillary force table (0 to use the analytic form)"},
             {"neighbor_update_period", INTEGER, "Neighbor list update period"},
+            {"reorder_particles", INTEGER, "Reorder particles along a Morton curve (0 / 1)"},
+            {"resume_checkpoint", INTEGER, "Resume from the last checkpoint on initialization (0 / 1)"},
             {"rng_seed", INTEGER, "Random number generator seed"},
-            {"aggregate_type", STRING, "vtk / flage / mackowski"},
+            {"aggregate_type", STRING, "vtk / flage / mackowski / generated"},
             {"aggregate_path", PATH, "Path to the aggregate file"}
     };
     static constexpr size_t N_PARAMETERS = sizeof(PARAMETERS) / sizeof(PARAMETERS[0]);
@@ -172,10 +200,21 @@ public:
 
 
 private:
+    void write_checkpoint() const;
+    bool restore_checkpoint(std::ostream & output_stream, double r_verlet);
+    void write_dump() const;
+
     double mass, inertia, r_part, dt;
-    long dump_period, neighbor_update_period;
+    long dump_period, neighbor_update_period, checkpoint_period;
+    bool resume_checkpoint;
+    double converged_ke, converged_rms_displacement;
+    long converged_dumps, n_converged_dumps = 0; // Convergence criteria and the number of consecutive dumps meeting them
     size_t current_step = 0;
+    std::vector<Eigen::Vector3d> x_prev; // Particle positions at the previous dump
+    std::vector<size_t> particle_order; // Original index of each particle, empty if the particles were not reordered
     std::unique_ptr<coating_model_t> coating_model;
+    std::unique_ptr<coating_table_model_t> coating_table_model;
+    std::unique_ptr<coating_mts_model_t> coating_mts_model;
     std::unique_ptr<aggregate_model_t> aggregate_model;
     std::unique_ptr<unary_force_container_t> unary_force_container;
     std::unique_ptr<binary_force_container_t> binary_force_container;
@@ -0,0 +1,346 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include "rigid_clusters.h"
+
+static const std::array<Eigen::Vector3d, 6> box_faces {
+        -Eigen::Vector3d::UnitX(),
+        Eigen::Vector3d::UnitX(),
+        -Eigen::Vector3d::UnitY(),
+        Eigen::Vector3d::UnitY(),
+        -Eigen::Vector3d::UnitZ(),
+        Eigen::Vector3d::UnitZ(),
+};
+
+// Union-find forest over n elements with path halving
+class DisjointSets {
+public:
+    explicit DisjointSets(size_t n)
+        : parent(n) {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    size_t find(size_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(size_t i, size_t j) {
+        parent[find(i)] = find(j);
+    }
+
+    // Elements of every set, ordered by their smallest element
+    std::vector<std::vector<size_t>> get_sets() {
+        std::vector<std::vector<size_t>> sets;
+        std::vector<size_t> set_index(parent.size(), parent.size());
+        for (size_t i = 0; i < parent.size(); i ++) {
+            size_t root = find(i);
+            if (set_index[root] == parent.size()) {
+                set_index[root] = sets.size();
+                sets.emplace_back();
+            }
+            sets[set_index[root]].emplace_back(i);
+        }
+        return sets;
+    }
+
+private:
+    std::vector<size_t> parent;
+};
+
+RigidClusterSystem::RigidClusterSystem(std::vector<Eigen::Vector3d> const & x,
+                                       std::vector<Eigen::Vector3d> const & v,
+                                       std::vector<Eigen::Vector3d> const & omega,
+                                       double r_part, double mass, double inertia, double box_size)
+    : n_part{x.size()}
+    , r_part{r_part}
+    , mass{mass}
+    , inertia{inertia}
+    , box_size{box_size} {
+
+    // Find the touching primaries by sweeping along the x-axis
+    std::vector<size_t> order(n_part);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&x] (size_t i, size_t j) {
+        return x[i][0] < x[j][0];
+    });
+
+    DisjointSets primary_sets(n_part);
+    for (size_t k = 0; k < n_part; k ++) {
+        for (size_t l = k + 1; l < n_part && x[order[l]][0] - x[order[k]][0] < 2.0 * r_part; l ++) {
+            if ((x[order[l]] - x[order[k]]).norm() < 2.0 * r_part)
+                primary_sets.unite(order[k], order[l]);
+        }
+    }
+
+    for (auto & members : primary_sets.get_sets()) {
+        std::vector<Eigen::Vector3d> positions;
+        Eigen::Vector3d center_of_mass = Eigen::Vector3d::Zero();
+        Eigen::Vector3d momentum = Eigen::Vector3d::Zero();
+        for (size_t i : members) {
+            positions.emplace_back(x[i]);
+            center_of_mass += x[i];
+            momentum += mass * v[i];
+        }
+        center_of_mass /= double(members.size());
+
+        Eigen::Vector3d angular_momentum = Eigen::Vector3d::Zero();
+        for (size_t i : members) {
+            angular_momentum += mass * (x[i] - center_of_mass).cross(v[i]) + inertia * omega[i];
+        }
+
+        clusters.emplace_back(make_cluster(std::move(members), positions, momentum, angular_momentum));
+    }
+}
+
+RigidClusterSystem::Cluster RigidClusterSystem::make_cluster(std::vector<size_t> members,
+                                                             std::vector<Eigen::Vector3d> const & positions,
+                                                             Eigen::Vector3d const & momentum,
+                                                             Eigen::Vector3d const & angular_momentum) const {
+    Cluster cluster;
+    cluster.members = std::move(members);
+    cluster.mass = mass * double(positions.size());
+    cluster.momentum = momentum;
+    cluster.angular_momentum = angular_momentum;
+
+    cluster.center_of_mass = Eigen::Vector3d::Zero();
+    for (auto const & position : positions) {
+        cluster.center_of_mass += position;
+    }
+    cluster.center_of_mass /= double(positions.size());
+
+    // Each primary contributes its own moment of inertia and that of its offset from the center of mass
+    Eigen::Matrix3d inertia_tensor = Eigen::Matrix3d::Zero();
+    for (auto const & position : positions) {
+        Eigen::Vector3d r = position - cluster.center_of_mass;
+        inertia_tensor += mass * (r.squaredNorm() * Eigen::Matrix3d::Identity() - r * r.transpose())
+                + inertia * Eigen::Matrix3d::Identity();
+    }
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(inertia_tensor);
+    Eigen::Matrix3d principal_axes = solver.eigenvectors();
+    if (principal_axes.determinant() < 0.0)
+        principal_axes.col(0) *= -1.0;
+
+    cluster.orientation = Eigen::Quaterniond(principal_axes);
+    cluster.inverse_principal_inertia = solver.eigenvalues().cwiseInverse();
+
+    cluster.radius = 0.0;
+    for (auto const & position : positions) {
+        Eigen::Vector3d r = position - cluster.center_of_mass;
+        cluster.body_offsets.emplace_back(principal_axes.transpose() * r);
+        cluster.radius = std::max(cluster.radius, r.norm());
+    }
+    cluster.radius += r_part;
+
+    return cluster;
+}
+
+Eigen::Vector3d RigidClusterSystem::get_angular_velocity(Cluster const & cluster) const {
+    Eigen::Matrix3d rotation = cluster.orientation.toRotationMatrix();
+    return rotation * cluster.inverse_principal_inertia.asDiagonal() * rotation.transpose() * cluster.angular_momentum;
+}
+
+std::vector<Eigen::Vector3d> RigidClusterSystem::get_member_positions(Cluster const & cluster) const {
+    Eigen::Matrix3d rotation = cluster.orientation.toRotationMatrix();
+    std::vector<Eigen::Vector3d> positions;
+    positions.reserve(cluster.body_offsets.size());
+    for (auto const & offset : cluster.body_offsets) {
+        positions.emplace_back(cluster.center_of_mass + rotation * offset);
+    }
+    return positions;
+}
+
+void RigidClusterSystem::bounce_off_walls(Cluster & cluster) const {
+    // A primary can only reach a wall if the bounding sphere does
+    if ((cluster.center_of_mass.cwiseAbs().array() + cluster.radius).maxCoeff() < box_size / 2.0)
+        return;
+
+    Eigen::Matrix3d rotation = cluster.orientation.toRotationMatrix();
+    Eigen::Matrix3d inverse_inertia = rotation * cluster.inverse_principal_inertia.asDiagonal() * rotation.transpose();
+
+    for (auto const & offset : cluster.body_offsets) {
+        Eigen::Vector3d r = rotation * offset;
+        for (auto const & face : box_faces) {
+            if (box_size / 2.0 - (cluster.center_of_mass + r).dot(face) >= r_part)
+                continue;
+
+            Eigen::Vector3d contact_velocity = cluster.momentum / cluster.mass + (inverse_inertia * cluster.angular_momentum).cross(r);
+            double normal_velocity = contact_velocity.dot(face);
+            if (normal_velocity <= 0.0)
+                continue;
+
+            // Elastic impulse that reverses the normal velocity of the contact point
+            double inverse_effective_mass = 1.0 / cluster.mass + face.dot((inverse_inertia * r.cross(face)).cross(r));
+            Eigen::Vector3d impulse = -2.0 * normal_velocity / inverse_effective_mass * face;
+            cluster.momentum += impulse;
+            cluster.angular_momentum += r.cross(impulse);
+        }
+    }
+}
+
+bool RigidClusterSystem::touching(Cluster const & first, Cluster const & second) const {
+    if ((first.center_of_mass - second.center_of_mass).norm() >= first.radius + second.radius)
+        return false;
+
+    // Only the primaries inside the bounding sphere of the other cluster (grown by one diameter) can touch it
+    auto get_candidates = [this] (Cluster const & cluster, Cluster const & other) {
+        std::vector<Eigen::Vector3d> candidates;
+        for (auto const & position : get_member_positions(cluster)) {
+            if ((position - other.center_of_mass).norm() < other.radius + r_part)
+                candidates.emplace_back(position);
+        }
+        return candidates;
+    };
+
+    auto first_candidates = get_candidates(first, second);
+    if (first_candidates.empty())
+        return false;
+    auto second_candidates = get_candidates(second, first);
+
+    for (auto const & p1 : first_candidates) {
+        for (auto const & p2 : second_candidates) {
+            if ((p1 - p2).norm() < 2.0 * r_part)
+                return true;
+        }
+    }
+    return false;
+}
+
+void RigidClusterSystem::merge_touching_clusters() {
+    // Broad phase: sweep and prune the bounding spheres along the x-axis
+    std::vector<size_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this] (size_t i, size_t j) {
+        return clusters[i].center_of_mass[0] - clusters[i].radius < clusters[j].center_of_mass[0] - clusters[j].radius;
+    });
+
+    DisjointSets cluster_sets(clusters.size());
+    bool merging = false;
+    for (size_t k = 0; k < order.size(); k ++) {
+        auto const & first = clusters[order[k]];
+        for (size_t l = k + 1; l < order.size(); l ++) {
+            auto const & second = clusters[order[l]];
+            if (second.center_of_mass[0] - second.radius >= first.center_of_mass[0] + first.radius)
+                break;
+            if (touching(first, second)) {
+                cluster_sets.unite(order[k], order[l]);
+                merging = true;
+            }
+        }
+    }
+
+    if (!merging)
+        return;
+
+    std::vector<Cluster> merged_clusters;
+    for (auto const & set : cluster_sets.get_sets()) {
+        if (set.size() == 1) {
+            merged_clusters.emplace_back(std::move(clusters[set.front()]));
+            continue;
+        }
+
+        double total_mass = 0.0;
+        Eigen::Vector3d center_of_mass = Eigen::Vector3d::Zero();
+        Eigen::Vector3d momentum = Eigen::Vector3d::Zero();
+        for (size_t k : set) {
+            total_mass += clusters[k].mass;
+            center_of_mass += clusters[k].mass * clusters[k].center_of_mass;
+            momentum += clusters[k].momentum;
+        }
+        center_of_mass /= total_mass;
+
+        // Angular momentum about the new center of mass is conserved in a perfectly inelastic collision
+        std::vector<size_t> members;
+        std::vector<Eigen::Vector3d> positions;
+        Eigen::Vector3d angular_momentum = Eigen::Vector3d::Zero();
+        for (size_t k : set) {
+            auto const & cluster = clusters[k];
+            angular_momentum += cluster.angular_momentum + (cluster.center_of_mass - center_of_mass).cross(cluster.momentum);
+            members.insert(members.end(), cluster.members.begin(), cluster.members.end());
+            auto member_positions = get_member_positions(cluster);
+            positions.insert(positions.end(), member_positions.begin(), member_positions.end());
+        }
+
+        merged_clusters.emplace_back(make_cluster(std::move(members), positions, momentum, angular_momentum));
+    }
+
+    clusters = std::move(merged_clusters);
+}
+
+void RigidClusterSystem::do_step(double dt) {
+    const long n_clusters = long(clusters.size());
+
+    #pragma omp parallel for default(none) shared(dt, n_clusters)
+    for (long k = 0; k < n_clusters; k ++) {
+        auto & cluster = clusters[k];
+        Eigen::Vector3d angular_velocity = get_angular_velocity(cluster);
+        double angle = angular_velocity.norm() * dt;
+
+        cluster.center_of_mass += cluster.momentum / cluster.mass * dt;
+        if (angle > 0.0) {
+            cluster.orientation = (Eigen::Quaterniond(Eigen::AngleAxisd(angle, angular_velocity.normalized()))
+                    * cluster.orientation).normalized();
+        }
+
+        bounce_off_walls(cluster);
+    }
+
+    merge_touching_clusters();
+}
+
+std::vector<Eigen::Vector3d> RigidClusterSystem::get_x() const {
+    std::vector<Eigen::Vector3d> x(n_part);
+    for (auto const & cluster : clusters) {
+        auto positions = get_member_positions(cluster);
+        for (size_t m = 0; m < cluster.members.size(); m ++) {
+            x[cluster.members[m]] = positions[m];
+        }
+    }
+    return x;
+}
+
+std::vector<Eigen::Vector3d> RigidClusterSystem::get_v() const {
+    std::vector<Eigen::Vector3d> v(n_part);
+    for (auto const & cluster : clusters) {
+        Eigen::Vector3d velocity = cluster.momentum / cluster.mass;
+        Eigen::Vector3d angular_velocity = get_angular_velocity(cluster);
+        auto positions = get_member_positions(cluster);
+        for (size_t m = 0; m < cluster.members.size(); m ++) {
+            v[cluster.members[m]] = velocity + angular_velocity.cross(positions[m] - cluster.center_of_mass);
+        }
+    }
+    return v;
+}
+
+std::vector<Eigen::Vector3d> RigidClusterSystem::get_omega() const {
+    std::vector<Eigen::Vector3d> omega(n_part);
+    for (auto const & cluster : clusters) {
+        Eigen::Vector3d angular_velocity = get_angular_velocity(cluster);
+        for (size_t i : cluster.members) {
+            omega[i] = angular_velocity;
+        }
+    }
+    return omega;
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SOOT_DEM_GUI_RIGID_CLUSTERS_H
+#define SOOT_DEM_GUI_RIGID_CLUSTERS_H
+
+#include <vector>
+
+#include <Eigen/Eigen>
+
+// Cluster-cluster aggregation of primaries that move as rigid bodies.
+// Each cluster carries its center of mass, momentum, angular momentum about the center of mass, and orientation
+// of its principal axes; its primaries are stored as fixed offsets in the principal frame.
+// Clusters move freely, bounce elastically off the box walls, and stick together as soon as two of their primaries touch,
+// conserving the total momentum and angular momentum. The cost of a step scales with the number of clusters
+// rather than the number of primaries, except for the narrow phase of clusters whose bounding spheres overlap
+class RigidClusterSystem {
+public:
+    // Primaries that are already touching are merged into the same cluster,
+    // so a state produced by get_x(), get_v(), and get_omega() can be used to restart the system
+    RigidClusterSystem(std::vector<Eigen::Vector3d> const & x,
+                       std::vector<Eigen::Vector3d> const & v,
+                       std::vector<Eigen::Vector3d> const & omega,
+                       double r_part, double mass, double inertia, double box_size);
+
+    void do_step(double dt);
+
+    size_t get_n_part() const {
+        return n_part;
+    }
+
+    size_t get_n_clusters() const {
+        return clusters.size();
+    }
+
+    // Per-primary state, in the original order of the primaries
+    std::vector<Eigen::Vector3d> get_x() const;
+    std::vector<Eigen::Vector3d> get_v() const;
+    std::vector<Eigen::Vector3d> get_omega() const;
+
+private:
+    struct Cluster {
+        std::vector<size_t> members;
+        std::vector<Eigen::Vector3d> body_offsets; // Member positions relative to the center of mass in the principal frame
+        Eigen::Vector3d center_of_mass, momentum, angular_momentum;
+        Eigen::Quaterniond orientation; // Rotation from the principal frame to the box frame
+        Eigen::Vector3d inverse_principal_inertia;
+        double mass, radius; // The bounding sphere about the center of mass encloses all member primaries
+    };
+
+    Cluster make_cluster(std::vector<size_t> members, std::vector<Eigen::Vector3d> const & positions,
+                         Eigen::Vector3d const & momentum, Eigen::Vector3d const & angular_momentum) const;
+    Eigen::Vector3d get_angular_velocity(Cluster const & cluster) const;
+    std::vector<Eigen::Vector3d> get_member_positions(Cluster const & cluster) const;
+    void bounce_off_walls(Cluster & cluster) const;
+    bool touching(Cluster const & first, Cluster const & second) const;
+    void merge_touching_clusters();
+
+    size_t n_part;
+    double r_part, mass, inertia, box_size;
+    std::vector<Cluster> clusters;
+};
+
+#endif //SOOT_DEM_GUI_RIGID_CLUSTERS_H
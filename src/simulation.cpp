@@ -15,6 +15,9 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <set>
 
 #include "simulation.h"
 
@@ -92,3 +95,67 @@ std::filesystem::path Simulation::get_path_parameter(std::string const & id) con
     }
     return parameter_itr->second.second.path_value;
 }
+
+// Run control options can be changed between restarts without invalidating the checkpoint
+static const std::set<std::string> RUN_CONTROL_PARAMETERS {
+        "checkpoint_period",
+        "converged_dumps",
+        "converged_ke",
+        "converged_rms_displacement",
+        "dt_safety_factor",
+        "force_table_tolerance",
+        "precision_check_steps",
+        "precision_check_tolerance",
+        "resume_checkpoint",
+        "sleep_ke"
+};
+
+std::string Simulation::get_parameter_fingerprint() const {
+    std::stringstream ss;
+    for (auto const & [id, parameter] : parameters) {
+        if (RUN_CONTROL_PARAMETERS.contains(id))
+            continue;
+        auto const & [type, value] = parameter;
+        ss << id << '=' << parameter_type_to_string(type) << ':';
+        // Reals are written exactly, so that different values never share a fingerprint
+        if (type == REAL)
+            ss << std::hexfloat << value.real_value << std::defaultfloat;
+        else
+            ss << parameter_value_to_string(type, value);
+        ss << ';';
+    }
+    return ss.str();
+}
+
+std::filesystem::path Simulation::get_checkpoint_path() const {
+    return dump_directory / "checkpoint.bin";
+}
+
+double Simulation::get_stable_time_step(double mass, double inertia, double r_part,
+                                        std::initializer_list<std::array<double, 4>> pair_springs,
+                                        std::initializer_list<std::array<double, 4>> substrate_springs,
+                                        double safety_factor) {
+    // Each spring acts on a relative displacement at the contact point. Its highest angular frequency is
+    // sqrt(k * (inverse effective mass of that displacement)). Rotations enter through the lever arm r_part
+    const double inverse_mass = 1.0 / mass;
+    const double inverse_rotation = r_part * r_part / inertia;
+
+    double omega_sq_max = 0.0;
+    for (auto const & [k_n, k_t, k_r, k_o] : pair_springs) {
+        // The tangential spring moves both particles and rotates both of them, rolling and torsional springs only rotate them
+        omega_sq_max = std::max({omega_sq_max,
+                                 k_n * 2.0 * inverse_mass,
+                                 k_t * 2.0 * (inverse_mass + inverse_rotation),
+                                 k_r * 2.0 * inverse_rotation,
+                                 k_o * 2.0 * inverse_rotation});
+    }
+    for (auto const & [k_n, k_t, k_r, k_o] : substrate_springs) {
+        omega_sq_max = std::max({omega_sq_max,
+                                 k_n * inverse_mass,
+                                 k_t * (inverse_mass + inverse_rotation),
+                                 k_r * inverse_rotation,
+                                 k_o * inverse_rotation});
+    }
+
+    return safety_factor * 2.0 / std::sqrt(omega_sq_max);
+}
@@ -19,7 +19,9 @@
 
 #include <string>
 #include <filesystem>
+#include <array>
 #include <map>
+#include <initializer_list>
 
 #include <Eigen/Eigen>
 
@@ -83,6 +85,12 @@ public:
                     std::vector<Eigen::Vector3d>,
                     std::vector<Eigen::Vector3d>,
                     std::vector<std::vector<Eigen::Vector3d>>> perform_iterations() = 0;
+    // True once the run has met its convergence criteria and should not be advanced further
+    virtual bool is_finished() const { return false; }
+    // True if is_finished can become true with the current parameters, so that the run stops on its own
+    virtual bool can_finish() const { return false; }
+    // Why the run stopped, valid once is_finished returns true
+    virtual std::string get_finish_reason() const { return {}; }
 
     long get_integer_parameter(std::string const & id) const;
     double get_real_parameter(std::string const & id) const;
@@ -90,6 +98,18 @@ public:
     std::filesystem::path get_path_parameter(std::string const & id) const;
 
 protected:
+    // Serialized parameter values, used to check that a checkpoint was written with the current configuration
+    std::string get_parameter_fingerprint() const;
+    std::filesystem::path get_checkpoint_path() const;
+    // Critical time step of velocity Verlet for the stiffest single spring, multiplied by the safety factor.
+    // Every entry holds the normal, tangential, rolling, and torsional stiffness {k_n, k_t, k_r, k_o} of one
+    // model. Pair springs join two free particles, substrate springs hold one particle against a fixed wall.
+    // A particle with several stiff contacts at once has a shorter critical step, use a safety factor below 1
+    static double get_stable_time_step(double mass, double inertia, double r_part,
+                                       std::initializer_list<std::array<double, 4>> pair_springs,
+                                       std::initializer_list<std::array<double, 4>> substrate_springs,
+                                       double safety_factor);
+
     parameter_heap_t parameters;
     std::filesystem::path simulation_working_directory;
     std::filesystem::path dump_directory;
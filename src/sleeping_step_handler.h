@@ -0,0 +1,331 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SOOT_DEM_GUI_SLEEPING_STEP_HANDLER_H
+#define SOOT_DEM_GUI_SLEEPING_STEP_HANDLER_H
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <tuple>
+#include <algorithm>
+#include <unordered_map>
+
+#include <libgran/granular_system/granular_system_neighbor_list.h>
+
+// Step handler that stops integrating particles at rest.
+// Frozen particles are never moved. A particle may fall asleep once it and all of its bonded neighbors have a kinetic
+// energy below the threshold, so the settled parts of an aggregate sleep while the rest of it is still moving.
+// Sleeping particles connected by necks form an island: their velocities are zeroed and the increments computed by the
+// integrator are accumulated instead of applied. As soon as the increments accumulated by any member amount to the
+// threshold kinetic energy, which happens when a contact forms or the forces change, the whole island wakes up (from rest).
+// The forces between sleeping particles are not evaluated when the force functors are wrapped in sleeping_force_filter.
+// A threshold of zero or less disables sleeping
+template <typename field_container_t, typename field_value_t>
+class sleeping_step_handler : public rotational_step_handler<field_container_t, field_value_t> {
+public:
+    using real_type = typename field_value_t::Scalar;
+    using base_t = rotational_step_handler<field_container_t, field_value_t>;
+
+    // Necks only act between particles closer than neck_range (the Verlet radius of the neighbor list)
+    void configure(size_t n_part, real_type mass, real_type inertia, real_type sleep_ke, real_type neck_range) {
+        this->mass = mass;
+        this->inertia = inertia;
+        this->sleep_ke = sleep_ke;
+        this->neck_range = neck_range;
+        state.assign(n_part, AWAKE);
+        island_of.assign(n_part, NO_ISLAND);
+        island_offsets.assign(1, 0);
+        island_members.clear();
+        wake_requested = std::vector<std::atomic<char>>();
+        any_wake_requested.store(false, std::memory_order_relaxed);
+        dv_sleeping.assign(n_part, field_value_t::Zero());
+        domega_sleeping.assign(n_part, field_value_t::Zero());
+    }
+
+    void freeze(size_t n) {
+        state[n] = FROZEN;
+    }
+
+    // Puts to sleep the slow particles whose bonded neighbors are all slow, and regroups the sleeping particles
+    // into islands. bonded_contacts is the n_part x n_part neck matrix of the aggregate model, it is only looked up
+    // for pairs found in a cell list of the positions, so the cost is linear in the number of particles
+    void update_sleeping(std::vector<bool> const & bonded_contacts,
+                         field_container_t const & x,
+                         field_container_t const & v,
+                         field_container_t const & omega) {
+        if (sleep_ke <= 0)
+            return;
+
+        apply_wake_requests();
+
+        const size_t n_part = state.size();
+        auto [neck_offsets, neck_partners] = find_necks(bonded_contacts, x);
+
+        std::vector<bool> fast(n_part);
+        for (size_t i = 0; i < n_part; i ++) {
+            fast[i] = state[i] == AWAKE && kinetic_energy(v[i], omega[i]) >= sleep_ke;
+        }
+
+        // Sleeping particles stay asleep, awake ones join them if neither they nor their bonded neighbors are moving
+        std::vector<bool> resting(n_part);
+        for (size_t i = 0; i < n_part; i ++) {
+            if (state[i] == SLEEPING) {
+                resting[i] = true;
+            } else if (state[i] == AWAKE && !fast[i]) {
+                resting[i] = std::none_of(neck_partners.begin() + long(neck_offsets[i]), neck_partners.begin() + long(neck_offsets[i + 1]),
+                                          [&fast] (size_t j) { return bool(fast[j]); });
+            }
+        }
+
+        // Label the islands of resting particles with a union-find forest over their necks
+        std::vector<size_t> root(n_part);
+        std::iota(root.begin(), root.end(), 0);
+        auto find = [&root] (size_t i) {
+            while (root[i] != i) {
+                root[i] = root[root[i]];
+                i = root[i];
+            }
+            return i;
+        };
+
+        for (size_t i = 0; i < n_part; i ++) {
+            if (!resting[i])
+                continue;
+            for (size_t k = neck_offsets[i]; k < neck_offsets[i + 1]; k ++) {
+                if (resting[neck_partners[k]])
+                    root[find(i)] = find(neck_partners[k]);
+            }
+        }
+
+        // Number the islands and list their members
+        std::vector<size_t> island_of_root(n_part, NO_ISLAND);
+        size_t n_islands = 0;
+        for (size_t i = 0; i < n_part; i ++) {
+            island_of[i] = NO_ISLAND;
+            if (!resting[i])
+                continue;
+            size_t & island = island_of_root[find(i)];
+            if (island == NO_ISLAND)
+                island = n_islands ++;
+            island_of[i] = island;
+
+            if (state[i] == AWAKE) {
+                state[i] = SLEEPING;
+                dv_sleeping[i] = field_value_t::Zero();
+                domega_sleeping[i] = field_value_t::Zero();
+            }
+        }
+
+        island_offsets.assign(n_islands + 1, 0);
+        for (size_t i = 0; i < n_part; i ++) {
+            if (island_of[i] != NO_ISLAND)
+                island_offsets[island_of[i] + 1] ++;
+        }
+        std::partial_sum(island_offsets.begin(), island_offsets.end(), island_offsets.begin());
+        island_members.resize(island_offsets.back());
+        std::vector<size_t> next_member(island_offsets.begin(), island_offsets.end() - 1);
+        for (size_t i = 0; i < n_part; i ++) {
+            if (island_of[i] != NO_ISLAND)
+                island_members[next_member[island_of[i]] ++] = i;
+        }
+
+        wake_requested = std::vector<std::atomic<char>>(n_islands);
+    }
+
+    // Wakes the islands in which a member has accumulated enough energy during the last step.
+    // Must be called between steps, so that all members of an island resume integration at the same step
+    void apply_wake_requests() {
+        if (!any_wake_requested.exchange(false, std::memory_order_acquire))
+            return;
+
+        for (size_t island = 0; island < wake_requested.size(); island ++) {
+            if (!wake_requested[island].exchange(0, std::memory_order_relaxed))
+                continue;
+            for (size_t k = island_offsets[island]; k < island_offsets[island + 1]; k ++) {
+                size_t i = island_members[k];
+                state[i] = AWAKE;
+                island_of[i] = NO_ISLAND;
+            }
+        }
+    }
+
+    bool is_awake(size_t n) const {
+        // An unconfigured handler integrates every particle
+        return state.empty() || state[n] == AWAKE;
+    }
+
+    size_t get_n_sleeping() const {
+        return std::count(state.begin(), state.end(), SLEEPING);
+    }
+
+    size_t get_n_frozen() const {
+        return std::count(state.begin(), state.end(), FROZEN);
+    }
+
+    // The integrator calls the increments in parallel, one thread per particle, so they only touch the state of particle n
+    // and the atomic wake request of its island
+
+    void increment_x(field_container_t & x, field_value_t const & dx, size_t n) {
+        if (is_awake(n))
+            base_t::increment_x(x, dx, n);
+    }
+
+    void increment_v(field_container_t & v, field_value_t const & dv, size_t n) {
+        if (!is_awake(n)) {
+            if (state[n] == SLEEPING) {
+                dv_sleeping[n] += dv;
+                request_wake(n);
+            }
+            v[n] = field_value_t::Zero();
+            return;
+        }
+        base_t::increment_v(v, dv, n);
+    }
+
+    void increment_theta(field_container_t & theta, field_value_t const & dtheta, size_t n) {
+        if (is_awake(n))
+            base_t::increment_theta(theta, dtheta, n);
+    }
+
+    void increment_omega(field_container_t & omega, field_value_t const & domega, size_t n) {
+        if (!is_awake(n)) {
+            if (state[n] == SLEEPING) {
+                domega_sleeping[n] += domega;
+                request_wake(n);
+            }
+            omega[n] = field_value_t::Zero();
+            return;
+        }
+        base_t::increment_omega(omega, domega, n);
+    }
+
+private:
+    enum ParticleState : char {AWAKE, SLEEPING, FROZEN};
+    static constexpr size_t NO_ISLAND = size_t(-1);
+
+    real_type kinetic_energy(field_value_t const & v, field_value_t const & omega) const {
+        return real_type(0.5) * (mass * v.squaredNorm() + inertia * omega.squaredNorm());
+    }
+
+    void request_wake(size_t n) {
+        if (kinetic_energy(dv_sleeping[n], domega_sleeping[n]) < sleep_ke)
+            return;
+
+        dv_sleeping[n] = field_value_t::Zero();
+        domega_sleeping[n] = field_value_t::Zero();
+        wake_requested[island_of[n]].store(1, std::memory_order_relaxed);
+        any_wake_requested.store(true, std::memory_order_release);
+    }
+
+    // Bonded neighbors of every particle in compressed rows, found through a cell list with cells neck_range wide
+    std::tuple<std::vector<size_t>, std::vector<size_t>> find_necks(std::vector<bool> const & bonded_contacts,
+                                                                    field_container_t const & x) const {
+        const size_t n_part = state.size();
+
+        auto get_cell = [this] (field_value_t const & particle) {
+            return std::array<long, 3> {long(std::floor(particle[0] / neck_range)),
+                                        long(std::floor(particle[1] / neck_range)),
+                                        long(std::floor(particle[2] / neck_range))};
+        };
+        auto get_key = [] (long ix, long iy, long iz) {
+            constexpr long offset = 1l << 20;
+            return uint64_t(ix + offset) << 42 | uint64_t(iy + offset) << 21 | uint64_t(iz + offset);
+        };
+
+        std::unordered_map<uint64_t, std::vector<size_t>> cells;
+        for (size_t i = 0; i < n_part; i ++) {
+            auto [cx, cy, cz] = get_cell(x[i]);
+            cells[get_key(cx, cy, cz)].emplace_back(i);
+        }
+
+        std::vector<size_t> neck_offsets(n_part + 1, 0), neck_partners;
+        for (size_t i = 0; i < n_part; i ++) {
+            auto [cx, cy, cz] = get_cell(x[i]);
+            for (long ix = cx - 1; ix <= cx + 1; ix ++) {
+                for (long iy = cy - 1; iy <= cy + 1; iy ++) {
+                    for (long iz = cz - 1; iz <= cz + 1; iz ++) {
+                        auto cell = cells.find(get_key(ix, iy, iz));
+                        if (cell == cells.end())
+                            continue;
+                        for (size_t j : cell->second) {
+                            if (j != i && bonded_contacts[i * n_part + j])
+                                neck_partners.emplace_back(j);
+                        }
+                    }
+                }
+            }
+            neck_offsets[i + 1] = neck_partners.size();
+        }
+
+        return {neck_offsets, neck_partners};
+    }
+
+    real_type mass = 0, inertia = 0, sleep_ke = 0, neck_range = 0;
+    std::vector<ParticleState> state;
+    std::vector<size_t> island_of; // Island of every sleeping particle
+    std::vector<size_t> island_offsets, island_members; // Members of every island in compressed rows
+    std::vector<std::atomic<char>> wake_requested; // Per island, set by the integrator threads
+    std::atomic<bool> any_wake_requested{false};
+    field_container_t dv_sleeping, domega_sleeping; // Increments accumulated while asleep
+};
+
+// Skips the evaluation of a force functor where it cannot move anything: binary forces between two particles that are
+// both asleep or frozen, and unary forces on particles that are not awake. Within a sleeping island the skipped forces
+// are in balance, so the increments accumulated by its members only come from the awake particles around it
+template<typename field_type, typename real_type, typename functor_t>
+class sleeping_force_filter {
+public:
+    using step_handler_t = sleeping_step_handler<std::vector<field_type>, field_type>;
+
+    sleeping_force_filter(functor_t & functor, step_handler_t const & step_handler)
+        : functor{functor}
+        , step_handler{step_handler} {}
+
+    std::pair<field_type, field_type> operator () (size_t i, size_t j,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        if (!step_handler.is_awake(i) && !step_handler.is_awake(j))
+            return {field_type::Zero(), field_type::Zero()};
+
+        return functor(i, j, x, v, theta, omega, t);
+    }
+
+    std::pair<field_type, field_type> operator () (size_t i,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        if (!step_handler.is_awake(i))
+            return {field_type::Zero(), field_type::Zero()};
+
+        return functor(i, x, v, theta, omega, t);
+    }
+
+private:
+    functor_t & functor;
+    step_handler_t const & step_handler;
+};
+
+#endif //SOOT_DEM_GUI_SLEEPING_STEP_HANDLER_H
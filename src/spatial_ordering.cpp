@@ -0,0 +1,75 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+#include "spatial_ordering.h"
+
+// Spread the lower 21 bits of a cell index so that two zero bits separate consecutive bits
+static uint64_t spread_bits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+std::vector<size_t> morton_order(std::vector<Eigen::Vector3d> const & x, double cell_size) {
+    std::vector<size_t> order(x.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if (x.empty())
+        return order;
+
+    Eigen::Vector3d x_min = x.front();
+    for (auto const & point : x) {
+        x_min = x_min.cwiseMin(point);
+    }
+
+    std::vector<uint64_t> codes(x.size());
+    for (size_t i = 0; i < x.size(); i ++) {
+        Eigen::Vector3d cell = (x[i] - x_min) / cell_size;
+        codes[i] = spread_bits(uint64_t(cell[0]))
+                | spread_bits(uint64_t(cell[1])) << 1
+                | spread_bits(uint64_t(cell[2])) << 2;
+    }
+
+    // Stable sort keeps the load order of particles that share a cell, so the ordering is reproducible
+    std::stable_sort(order.begin(), order.end(), [&codes] (size_t a, size_t b) {
+        return codes[a] < codes[b];
+    });
+
+    return order;
+}
+
+std::vector<bool> const & restore_pair_order(std::vector<bool> const & pairs, std::vector<size_t> const & order,
+                                             std::vector<bool> & buffer) {
+    if (order.empty())
+        return pairs;
+
+    size_t n = order.size();
+    buffer.assign(pairs.size(), false);
+    for (size_t i = 0; i < n; i ++) {
+        for (size_t j = 0; j < n; j ++) {
+            buffer[order[i] * n + order[j]] = pairs[i * n + j];
+        }
+    }
+    return buffer;
+}
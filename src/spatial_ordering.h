@@ -0,0 +1,59 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_SPATIAL_ORDERING_H
+#define SOOT_DEM_GUI_SPATIAL_ORDERING_H
+
+#include <vector>
+
+#include <Eigen/Eigen>
+
+// Order in which the particles are visited by a Morton (Z-order) curve through cubic cells of size cell_size.
+// Element k of the result is the original index of the particle that is placed at position k,
+// so that particles that are close in space are also close in memory
+std::vector<size_t> morton_order(std::vector<Eigen::Vector3d> const & x, double cell_size);
+
+// Rearrange per-particle values into the given order
+template<typename T>
+std::vector<T> apply_order(std::vector<T> const & values, std::vector<size_t> const & order) {
+    std::vector<T> result(values.size());
+    for (size_t k = 0; k < order.size(); k ++) {
+        result[k] = values[order[k]];
+    }
+    return result;
+}
+
+// Inverse of apply_order. An empty order means that the particles were never reordered,
+// in which case values are returned as they are. Otherwise the result is written to buffer
+template<typename T>
+std::vector<T> const & restore_order(std::vector<T> const & values, std::vector<size_t> const & order,
+                                     std::vector<T> & buffer) {
+    if (order.empty())
+        return values;
+
+    buffer.resize(values.size());
+    for (size_t k = 0; k < order.size(); k ++) {
+        buffer[order[k]] = values[k];
+    }
+    return buffer;
+}
+
+// Inverse of apply_order for an N x N row-major matrix of pairwise flags, such as the bonded contacts.
+// Follows the same conventions as restore_order
+std::vector<bool> const & restore_pair_order(std::vector<bool> const & pairs, std::vector<size_t> const & order,
+                                             std::vector<bool> & buffer);
+
+#endif //SOOT_DEM_GUI_SPATIAL_ORDERING_H
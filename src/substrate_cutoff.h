@@ -0,0 +1,70 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SOOT_DEM_GUI_SUBSTRATE_CUTOFF_H
+#define SOOT_DEM_GUI_SUBSTRATE_CUTOFF_H
+
+#include <vector>
+#include <utility>
+
+// Restricts a substrate (unary) force functor to the slab of particles whose centers lie within the cutoff height
+// above the substrate plane at z=0, so that the contact, Hamaker, and coating terms are not evaluated for the rest
+// of the aggregate. The wrapped functor is not called for particles above the slab, so the cutoff must exceed
+// the range of any stateful (contact) term for its history to be reset before a particle leaves the slab.
+// Inside the slab, the acceleration at the cutoff height is subtracted so that the force vanishes continuously there
+// instead of dropping to zero. The shift is evaluated once, above the origin of the substrate plane, which assumes
+// that the substrate force does not vary laterally.
+// A cutoff of zero or less disables the check
+template<typename field_type, typename real_type, typename functor_t>
+class substrate_cutoff_functor {
+public:
+    substrate_cutoff_functor(functor_t & functor, real_type cutoff)
+        : functor{functor}
+        , cutoff{cutoff} {
+
+        if (cutoff <= 0)
+            return;
+
+        // The contact terms are out of range at the cutoff, so only the Hamaker and coating terms contribute
+        std::vector<field_type> x_cutoff {cutoff * field_type::UnitZ()};
+        std::vector<field_type> zeros {field_type::Zero()};
+        shift = functor(0, x_cutoff, zeros, zeros, zeros, 0).first;
+    }
+
+    std::pair<field_type, field_type> operator () (size_t i,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        if (cutoff <= 0)
+            return functor(i, x, v, theta, omega, t);
+
+        if (x[i][2] >= cutoff)
+            return {field_type::Zero(), field_type::Zero()};
+
+        auto [a, alpha] = functor(i, x, v, theta, omega, t);
+        return {a - shift, alpha};
+    }
+
+private:
+    functor_t & functor;
+    const real_type cutoff;
+    field_type shift = field_type::Zero();
+};
+
+#endif //SOOT_DEM_GUI_SUBSTRATE_CUTOFF_H
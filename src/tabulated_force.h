@@ -0,0 +1,147 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_TABULATED_FORCE_H
+#define SOOT_DEM_GUI_TABULATED_FORCE_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+// Replaces a central binary force functor that only depends on the distance between the two particles
+// (Hamaker, capillary coating) with cubic (Catmull-Rom) interpolation in a table of the analytic values
+// sampled at n_points uniformly spaced distances in [r_min, r_max].
+// If the analytic force jumps at r_knot (inside the table), the table is split into two segments that meet
+// at r_knot and are interpolated independently, so the jump is kept instead of being smeared across the
+// neighboring points. A segment samples the limit of the force from its own side of the knot.
+// Distances outside of the table, and every distance if n_points is below 4 per segment, are passed to the analytic functor
+template<typename field_type, typename real_type, typename functor_t>
+class tabulated_force_functor {
+public:
+    tabulated_force_functor(functor_t & analytic_functor, real_type r_min, real_type r_max, size_t n_points, real_type r_knot = 0)
+        : analytic_functor{analytic_functor}
+        , r_min{r_min}
+        , r_max{r_max} {
+
+        if (r_knot <= r_min || r_knot >= r_max) {
+            if (n_points >= 4)
+                segments.emplace_back(make_segment(r_min, r_max, r_min, r_max, n_points));
+            return;
+        }
+
+        // Points are shared out in proportion to the segment lengths
+        auto n_lower = size_t(std::round(real_type(n_points) * (r_knot - r_min) / (r_max - r_min)));
+        auto n_upper = n_points - std::min(n_lower, n_points);
+        if (n_lower < 4 || n_upper < 4)
+            return;
+
+        segments.emplace_back(make_segment(r_min, r_knot, r_min, std::nextafter(r_knot, r_min), n_lower));
+        segments.emplace_back(make_segment(r_knot, r_max, std::nextafter(r_knot, r_max), r_max, n_upper));
+    }
+
+    bool is_tabulated() const {
+        return !segments.empty();
+    }
+
+    // Largest deviation from the analytic functor halfway between the table points, relative to the analytic
+    // value there. Values smaller than a 1e-9 fraction of the largest tabulated magnitude are compared against
+    // that floor instead, so that zeros of the force do not dominate the result
+    real_type get_max_relative_error() {
+        real_type max_magnitude = 0;
+        for (auto const & segment : segments) {
+            for (auto value : segment.table) {
+                max_magnitude = std::max(max_magnitude, std::abs(value));
+            }
+        }
+        const real_type floor = real_type(1e-9) * max_magnitude;
+
+        real_type max_error = 0;
+        for (auto const & segment : segments) {
+            for (size_t k = 0; k + 1 < segment.table.size(); k ++) {
+                real_type r = segment.r_begin + (real_type(k) + real_type(0.5)) * segment.spacing;
+                real_type exact = sample(r);
+                real_type scale = std::max(std::abs(exact), floor);
+                if (scale > 0)
+                    max_error = std::max(max_error, std::abs(interpolate(segment, r) - exact) / scale);
+            }
+        }
+        return max_error;
+    }
+
+    std::pair<field_type, field_type> operator () (size_t i, size_t j,
+                                                   std::vector<field_type> const & x,
+                                                   std::vector<field_type> const & v,
+                                                   std::vector<field_type> const & theta,
+                                                   std::vector<field_type> const & omega,
+                                                   real_type t) {
+        field_type r_ij = x[j] - x[i];
+        real_type r = r_ij.norm();
+
+        if (segments.empty() || r < r_min || r >= r_max)
+            return analytic_functor(i, j, x, v, theta, omega, t);
+
+        auto const & segment = segments.size() > 1 && r >= segments[1].r_begin ? segments[1] : segments[0];
+        return {interpolate(segment, r) / r * r_ij, field_type::Zero()};
+    }
+
+private:
+    struct segment_t {
+        real_type r_begin, spacing;
+        std::vector<real_type> table;
+    };
+
+    // Samples n_points of the analytic force on [r_begin, r_end]. The end points can be sampled at slightly
+    // different distances (sample_begin, sample_end) to take the one-sided limit of the force at a knot
+    segment_t make_segment(real_type r_begin, real_type r_end, real_type sample_begin, real_type sample_end, size_t n_points) {
+        segment_t segment{r_begin, (r_end - r_begin) / real_type(n_points - 1), std::vector<real_type>(n_points)};
+        for (size_t k = 0; k < n_points; k ++) {
+            real_type r = r_begin + real_type(k) * segment.spacing;
+            segment.table[k] = sample(std::clamp(r, sample_begin, sample_end));
+        }
+        return segment;
+    }
+
+    // Component of the analytic acceleration of particle i along the direction towards particle j
+    real_type sample(real_type r) {
+        std::vector<field_type> x_pair {field_type::Zero(), r * field_type::UnitX()};
+        std::vector<field_type> zeros(2, field_type::Zero());
+        return analytic_functor(0, 1, x_pair, zeros, zeros, zeros, 0).first[0];
+    }
+
+    static real_type interpolate(segment_t const & segment, real_type r) {
+        auto const & table = segment.table;
+        real_type s = std::max(r - segment.r_begin, real_type(0)) / segment.spacing;
+        auto k = std::min(size_t(s), table.size() - 2);
+        real_type u = s - real_type(k);
+
+        // Missing neighbors at the ends of a segment are extrapolated linearly
+        real_type p0 = k > 0 ? table[k - 1] : 2 * table[k] - table[k + 1];
+        real_type p1 = table[k];
+        real_type p2 = table[k + 1];
+        real_type p3 = k + 2 < table.size() ? table[k + 2] : 2 * table[k + 1] - table[k];
+
+        return p1 + real_type(0.5) * u * (p2 - p0
+            + u * (2 * p0 - 5 * p1 + 4 * p2 - p3
+            + u * (3 * (p1 - p2) + p3 - p0)));
+    }
+
+    functor_t & analytic_functor;
+    const real_type r_min, r_max;
+    std::vector<segment_t> segments; // One segment, or two that meet at the knot
+};
+
+#endif //SOOT_DEM_GUI_TABULATED_FORCE_H
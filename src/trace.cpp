@@ -0,0 +1,149 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "exceptions.h"
+#include "trace.h"
+
+// Number of most recent events retained per thread
+static constexpr size_t TRACE_BUFFER_CAPACITY = 1u << 18u;
+
+struct TraceEvent {
+    const char * name;
+    long long begin_us;
+    long long end_us;
+};
+
+struct TraceBuffer {
+    std::array<TraceEvent, TRACE_BUFFER_CAPACITY> events;
+    std::atomic<size_t> head{0}; // Total number of events ever recorded into this buffer
+    long thread_id;
+    std::atomic<const char *> thread_name{nullptr};
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::shared_ptr<TraceBuffer>> registry; // Buffers outlive their threads
+static const auto trace_epoch = std::chrono::steady_clock::now();
+
+static long long trace_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - trace_epoch).count();
+}
+
+static TraceBuffer & get_thread_buffer() {
+    thread_local std::shared_ptr<TraceBuffer> buffer = [] {
+        auto new_buffer = std::make_shared<TraceBuffer>();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        new_buffer->thread_id = long(registry.size()) + 1;
+        registry.emplace_back(new_buffer);
+        return new_buffer;
+    }();
+    return *buffer;
+}
+
+TraceScope::TraceScope(const char * name)
+    : name{name}
+    , begin_us{trace_now_us()} {}
+
+TraceScope::~TraceScope() {
+    auto & buffer = get_thread_buffer();
+    // Only this thread writes to the buffer, so a relaxed load of its own counter is sufficient
+    size_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % TRACE_BUFFER_CAPACITY] = {name, begin_us, trace_now_us()};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void set_trace_thread_name(const char * name) {
+    get_thread_buffer().thread_name.store(name, std::memory_order_release);
+}
+
+static void write_json_string(std::ostream & out, const char * str) {
+    out << '"';
+    for (; *str != '\0'; str ++) {
+        if (*str == '"' || *str == '\\')
+            out << '\\';
+        out << *str;
+    }
+    out << '"';
+}
+
+void write_chrome_trace(std::filesystem::path const & path) {
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffers = registry;
+    }
+
+    std::ofstream out(path);
+    if (!out.good())
+        throw UiException("Unable to open trace file for writing");
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first_event = true;
+    auto separator = [&out, &first_event] () {
+        if (!first_event)
+            out << ",\n";
+        first_event = false;
+    };
+
+    for (auto const & buffer : buffers) {
+        const char * thread_name = buffer->thread_name.load(std::memory_order_acquire);
+        if (thread_name != nullptr) {
+            separator();
+            out << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << buffer->thread_id << R"(,"args":{"name":)";
+            write_json_string(out, thread_name);
+            out << "}}";
+        }
+
+        // Copy the retained window of events while the owning thread may still be recording
+        size_t head = buffer->head.load(std::memory_order_acquire);
+        size_t first = head > TRACE_BUFFER_CAPACITY ? head - TRACE_BUFFER_CAPACITY : 0;
+        std::vector<TraceEvent> events;
+        events.reserve(head - first);
+        for (size_t n = first; n < head; n ++) {
+            events.emplace_back(buffer->events[n % TRACE_BUFFER_CAPACITY]);
+        }
+
+        // Discard the slots that were overwritten while copying, including the slot
+        // that event number head_after may still be in the middle of overwriting
+        size_t head_after = buffer->head.load(std::memory_order_acquire);
+        size_t first_valid = head_after >= TRACE_BUFFER_CAPACITY ? head_after - TRACE_BUFFER_CAPACITY + 1 : 0;
+        size_t skip = first_valid > first ? std::min(first_valid - first, events.size()) : 0;
+
+        for (size_t n = skip; n < events.size(); n ++) {
+            separator();
+            out << R"({"ph":"X","pid":1,"tid":)" << buffer->thread_id
+                << R"(,"ts":)" << events[n].begin_us
+                << R"(,"dur":)" << events[n].end_us - events[n].begin_us
+                << R"(,"name":)";
+            write_json_string(out, events[n].name);
+            out << "}";
+        }
+    }
+
+    out << "]}\n";
+
+    if (!out.good())
+        throw UiException("Unable to write trace file");
+}
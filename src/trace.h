@@ -0,0 +1,56 @@
+// Copyright (C) 2024 Egor Demidov
+// This file is part of soot-dem-gui
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SOOT_DEM_GUI_TRACE_H
+#define SOOT_DEM_GUI_TRACE_H
+
+#include <filesystem>
+
+// Scoped timer that records a complete (begin + end) event into a buffer owned by the calling thread.
+// Each thread appends to its own ring buffer without taking a lock; only the first event recorded
+// by a thread and the export touch the shared registry of buffers.
+// The name must point to a string with static storage duration (a literal)
+class TraceScope {
+public:
+    explicit TraceScope(const char * name);
+    ~TraceScope();
+
+    TraceScope(TraceScope const &) = delete;
+    TraceScope & operator = (TraceScope const &) = delete;
+
+private:
+    const char * name;
+    long long begin_us;
+};
+
+// Label the calling thread in the exported trace
+void set_trace_thread_name(const char * name);
+
+// Write the events recorded so far by all threads in the Chrome Trace Event format
+// (can be opened with chrome://tracing or https://ui.perfetto.dev)
+void write_chrome_trace(std::filesystem::path const & path);
+
+#ifdef USE_TRACING
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) set_trace_thread_name(name)
+#else //USE_TRACING
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+#endif //USE_TRACING
+
+#endif //SOOT_DEM_GUI_TRACE_H